@@ -0,0 +1,51 @@
+#ifndef ALARM_H
+#define ALARM_H
+
+#include <stdint.h>
+
+/*
+non-blocking alarm sound engine. a pattern is a list of notes in flash;
+alarmStart() only records which pattern to play, and alarmPoll(), run
+every few milliseconds by the sound task, starts each note with a
+non-waiting playTone() (the tone timer ends it) once the previous one
+is over. sampling and analysis carry on while an alarm sounds.
+
+every pattern plays its notes `repeats` times. a pattern of higher
+priority preempts the one playing; a request of the same or lower
+priority is dropped while something is playing. the alarm patterns
+escalate: ALARM_NOTICE for a first alarming evaluation period,
+ALARM_WARNING and then ALARM_URGENT while the periods keep alarming.
+alarmSnooze() silences the engine and drops every request until it
+runs out.
+
+the button clicks are patterns too, at alarmClickPriority: they cut
+into whatever is playing and still sound during a snooze.
+*/
+
+struct AlarmNote {
+    uint16_t freq;  // Hz, 0 for a rest
+    uint16_t ms;
+};
+
+struct AlarmPattern {
+    const AlarmNote *notes;  // in flash
+    uint8_t count;
+    uint8_t repeats;
+    uint8_t priority;
+};
+
+enum AlarmId { ALARM_TEST, ALARM_NOTICE, ALARM_WARNING, ALARM_URGENT, ALARM_CLICK_POWER, ALARM_CLICK_ALARM, ALARM_COUNT };
+
+const uint8_t alarmClickPriority = 4;
+
+void alarmStart(uint8_t pattern);
+void alarmStop();
+// silence the alarm for the given time; 0 ends a snooze
+void alarmSnooze(uint32_t ms);
+bool alarmPlaying();
+bool alarmSnoozed();
+// start the next note if the current one is over
+void alarmPoll();
+void alarmReport();
+
+#endif
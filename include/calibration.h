@@ -0,0 +1,27 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <stdint.h>
+#include "params.h"
+
+/*
+per-patient calibration profiles kept in EEPROM. a profile is a
+TuningParams set wrapped in a versioned, CRC-checked record. saves
+rotate through a ring of slots so repeated tuning spreads the wear
+instead of rewriting the same cells, and the slot holding the highest
+sequence number with a good CRC is the current profile.
+*/
+
+const uint16_t calibrationBase = 0;  // first EEPROM byte used by the slot ring
+const uint8_t calibrationSlots = 8;
+
+// newest valid profile into `p`, false (and `p` untouched) if none is stored
+bool calibrationLoad(TuningParams &p);
+// write `p` into the slot after the newest one
+bool calibrationSave(const TuningParams &p);
+// slot index of the last load/save, -1 when running on defaults
+int8_t calibrationSlot();
+// first EEPROM byte past the slot ring, free for other records
+uint16_t calibrationEnd();
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+/*
+line based serial command console. consolePoll() only consumes bytes
+that have already arrived, so it never blocks loop(); a command runs
+once its terminating newline is seen.
+
+  get                 print every tunable parameter
+  set <name> <value>  validate and queue a change for the next frame
+  defaults            queue the compiled-in defaults
+  save                store the current set as this wearer's EEPROM profile
+  load                queue the stored profile
+  stream on|off       binary spectrogram packets after every frame
+  mem                 SRAM report
+  sched [reset]       per-task deadline misses, latency and slice times
+  timing [reset]      sample jitter histogram, missed samples, rate and overruns
+  alarm               playing pattern and snooze time left
+  alarm snooze [min]  silence alarms for min minutes (10), 0 to resume
+  alarm stop|test     end the playing pattern / play a short test beep
+  history [clear]     per-minute intensity history from EEPROM, oldest first
+  trend [minutes]     frames, mean, peak, peak Hz and danger fraction over the
+                      last minutes (60), from the minute/hour/day rollups
+  trend days          the same for today and each kept day
+  prof [reset]        per-stage cycle profile (ENABLE_PROFILER builds)
+*/
+void consolePoll();
+
+#endif
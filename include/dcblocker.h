@@ -0,0 +1,46 @@
+#ifndef DCBLOCKER_H
+#define DCBLOCKER_H
+
+#include <stdint.h>
+
+/*
+integer DC (gravity) removal ahead of the FFT. the accelerometer
+magnitude carries a ~9.8 m/s^2 offset that would otherwise leak
+through the window into the lowest bins and use up most of the
+numeric range of the frame.
+
+a leaky integrator tracks the running mean and subtracts it, which is
+a single-pole high-pass with its pole at 1 - 2^-dcBlockerShift. with
+shift 5 the corner sits near 0.25 Hz at 50 Hz sampling, far below the
+tremor band. only adds, subtracts and shifts are used.
+*/
+
+const int32_t dcScale = 1024;      // integer counts per m/s^2
+const uint8_t dcBlockerShift = 5;
+
+// one blocker's state; the sketch keeps one, the host tools one per recording
+struct DcBlocker {
+    int32_t accumulator = 0;  // running mean scaled by 2^dcBlockerShift
+    bool primed = false;
+
+    void reset() {
+        primed = false;
+    }
+
+    int32_t step(int32_t sample) {
+        if (!primed) {
+            // start from the first reading instead of ramping up from zero
+            accumulator = sample << dcBlockerShift;
+            primed = true;
+        }
+        accumulator += sample - (accumulator >> dcBlockerShift);
+        return sample - (accumulator >> dcBlockerShift);
+    }
+};
+
+// forget the running mean; the next sample re-seeds it
+void dcBlockerReset();
+// one sample in dcScale counts, returns it with the running mean removed
+int32_t dcBlockerStep(int32_t sample);
+
+#endif
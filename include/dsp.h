@@ -0,0 +1,446 @@
+#ifndef DSP_H
+#define DSP_H
+
+#include <stdint.h>
+#include <math.h>
+#include "dsp_tables.h"
+
+/*
+the tremor DSP path (window, FFT, magnitude, Welch averaging and band
+search) as a template over its numeric types, so the same code runs in
+float, double, Q15 (int16_t) or Q31 (int32_t) on the device and on the
+host. nothing here depends on Arduino; the host benchmark in tools/
+compiles this header directly.
+
+every type holds samples normalized to dspFullScale m/s^2. the fixed
+point types halve each butterfly stage so the transform cannot
+overflow; TremorDsp keeps track of that shift and magnitude() always
+answers in the same physical units the float path does. no trig is
+evaluated per frame: the twiddles and the window both come from the
+cosine tables in dsp_tables.h (scripts/gen_tables.py), read from flash
+in each type's own format.
+*/
+
+const double dspFullScale = 32.0;  // m/s^2 represented by 1.0 (gravity is removed before this point)
+const uint8_t dspStepItems = 16;   // most butterflies (or bins) one TremorDsp::step() works through
+
+template <typename T> struct DspTraits;
+
+template <> struct DspTraits<float> {
+    typedef float accum_t;
+    static const uint8_t stageShift = 0;
+    static const char *name() { return "float"; }
+    static float fromReal(double v) { return v; }
+    static float fromFixed(int32_t v, uint8_t fracBits) { return ldexp((float)v, -fracBits); }
+    static float fromTable(uint8_t i) { return pgm_read_float(&dspCosFloat[i]); }
+    static float hamming(float c) { return 0.54f - 0.46f * c; }
+    static double toReal(float v) { return v; }
+    static float mul(float a, float b) { return a * b; }
+    static void butterfly(float &ar, float &ai, float &br, float &bi, float wr, float wi) {
+        float tr = br * wr - bi * wi;
+        float ti = br * wi + bi * wr;
+        br = ar - tr;
+        bi = ai - ti;
+        ar += tr;
+        ai += ti;
+    }
+    static float magnitude(float re, float im) { return sqrt(re * re + im * im); }
+    static accum_t power(float re, float im) { return re * re + im * im; }
+    static float rootMean(accum_t sum, uint8_t count) { return sqrt(sum / count); }
+};
+
+template <> struct DspTraits<double> {
+    typedef double accum_t;
+    static const uint8_t stageShift = 0;
+    static const char *name() { return "double"; }
+    static double fromReal(double v) { return v; }
+    static double fromFixed(int32_t v, uint8_t fracBits) { return ldexp((double)v, -fracBits); }
+    static double fromTable(uint8_t i) { return dspReadDouble(&dspCosDouble[i]); }
+    static double hamming(double c) { return 0.54 - 0.46 * c; }
+    static double toReal(double v) { return v; }
+    static double mul(double a, double b) { return a * b; }
+    static void butterfly(double &ar, double &ai, double &br, double &bi, double wr, double wi) {
+        double tr = br * wr - bi * wi;
+        double ti = br * wi + bi * wr;
+        br = ar - tr;
+        bi = ai - ti;
+        ar += tr;
+        ai += ti;
+    }
+    static double magnitude(double re, double im) { return sqrt(re * re + im * im); }
+    static accum_t power(double re, double im) { return re * re + im * im; }
+    static double rootMean(accum_t sum, uint8_t count) { return sqrt(sum / count); }
+};
+
+// integer square roots for the fixed point magnitudes
+inline uint16_t dspSqrt32(uint32_t v) {
+    uint32_t root = 0, bit = 1UL << 30;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+inline uint32_t dspSqrt64(uint64_t v) {
+    uint64_t root = 0, bit = 1ULL << 62;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+// Q15: 1 sign bit, 15 fraction bits
+template <> struct DspTraits<int16_t> {
+    typedef int32_t accum_t;
+    static const uint8_t stageShift = 1;
+    static const uint8_t powerShift = 5;  // headroom for summing 15 Welch segments
+    static const char *name() { return "q15"; }
+    static int16_t saturate(int32_t v) { return v > 32767 ? 32767 : (v < -32768 ? -32768 : v); }
+    static int16_t fromReal(double v) { return saturate(lround(v * 32768)); }
+    static int16_t fromFixed(int32_t v, uint8_t fracBits) {
+        return saturate(fracBits <= 15 ? v << (15 - fracBits) : v >> (fracBits - 15));
+    }
+    static int16_t fromTable(uint8_t i) { return pgm_read_word(&dspCosQ15[i]); }
+    // 0.54 - 0.46 * c, saturated at the top where c = -1
+    static int16_t hamming(int16_t c) { return saturate(17695L - (((int32_t)15073 * c + 0x4000) >> 15)); }
+    static double toReal(int16_t v) { return v / 32768.0; }
+    static int16_t mul(int16_t a, int16_t b) { return saturate(((int32_t)a * b + 0x4000) >> 15); }
+    // a, b = (a + w * b) / 2, (a - w * b) / 2 with the product kept at 32 bits
+    static void butterfly(int16_t &ar, int16_t &ai, int16_t &br, int16_t &bi, int16_t wr, int16_t wi) {
+        int32_t tr = ((int32_t)br * wr - (int32_t)bi * wi + 0x4000) >> 15;
+        int32_t ti = ((int32_t)br * wi + (int32_t)bi * wr + 0x4000) >> 15;
+        br = saturate((ar - tr) >> 1);
+        bi = saturate((ai - ti) >> 1);
+        ar = saturate((ar + tr) >> 1);
+        ai = saturate((ai + ti) >> 1);
+    }
+    static int16_t magnitude(int16_t re, int16_t im) {
+        uint32_t p = (uint32_t)((int32_t)re * re) + (uint32_t)((int32_t)im * im);
+        uint16_t m = dspSqrt32(p);
+        return m > 32767 ? 32767 : m;
+    }
+    static accum_t power(int16_t re, int16_t im) {
+        return (((int32_t)re * re) >> powerShift) + (((int32_t)im * im) >> powerShift);
+    }
+    static int16_t rootMean(accum_t sum, uint8_t count) {
+        uint16_t m = dspSqrt32((uint32_t)(sum / count) << powerShift);
+        return m > 32767 ? 32767 : m;
+    }
+};
+
+// Q31: 1 sign bit, 31 fraction bits
+template <> struct DspTraits<int32_t> {
+    typedef int64_t accum_t;
+    static const uint8_t stageShift = 1;
+    static const uint8_t powerShift = 5;
+    static const char *name() { return "q31"; }
+    static int32_t saturate(int64_t v) {
+        return v > 2147483647LL ? 2147483647L : (v < -2147483648LL ? (-2147483647L - 1) : (int32_t)v);
+    }
+    static int32_t fromReal(double v) { return saturate((int64_t)floor(v * 2147483648.0 + 0.5)); }
+    static int32_t fromFixed(int32_t v, uint8_t fracBits) {
+        return saturate(fracBits <= 31 ? (int64_t)v << (31 - fracBits) : (int64_t)v >> (fracBits - 31));
+    }
+    static int32_t fromTable(uint8_t i) { return pgm_read_dword(&dspCosQ31[i]); }
+    static int32_t hamming(int32_t c) {
+        return saturate(1159641170LL - (((int64_t)987842478L * c + 0x40000000LL) >> 31));
+    }
+    static double toReal(int32_t v) { return v / 2147483648.0; }
+    static int32_t mul(int32_t a, int32_t b) { return saturate(((int64_t)a * b + 0x40000000LL) >> 31); }
+    static void butterfly(int32_t &ar, int32_t &ai, int32_t &br, int32_t &bi, int32_t wr, int32_t wi) {
+        int64_t tr = ((int64_t)br * wr - (int64_t)bi * wi + 0x40000000LL) >> 31;
+        int64_t ti = ((int64_t)br * wi + (int64_t)bi * wr + 0x40000000LL) >> 31;
+        br = saturate((ar - tr) >> 1);
+        bi = saturate((ai - ti) >> 1);
+        ar = saturate((ar + tr) >> 1);
+        ai = saturate((ai + ti) >> 1);
+    }
+    static int32_t magnitude(int32_t re, int32_t im) {
+        uint64_t p = (uint64_t)((int64_t)re * re) + (uint64_t)((int64_t)im * im);
+        uint32_t m = dspSqrt64(p);
+        return m > 2147483647UL ? 2147483647L : m;
+    }
+    static accum_t power(int32_t re, int32_t im) {
+        return (((int64_t)re * re) >> powerShift) + (((int64_t)im * im) >> powerShift);
+    }
+    static int32_t rootMean(accum_t sum, uint8_t count) {
+        uint32_t m = dspSqrt64((uint64_t)(sum / count) << powerShift);
+        return m > 2147483647UL ? 2147483647L : m;
+    }
+};
+
+/*
+one analysis frame of N samples. samples are loaded into re[], then
+transform() (or welch()) leaves the magnitude spectrum in re[] in
+place, the same way ArduinoFFT's complexToMagnitude() did. im[] is
+workspace. the spectrum therefore shares the Sample type; Accum is the
+type the Welch power sums are kept in.
+*/
+template <typename Sample, uint16_t N, typename Accum = typename DspTraits<Sample>::accum_t>
+class TremorDsp {
+    static_assert(N >= 4 && N <= dspTablePoints && (N & (N - 1)) == 0,
+                  "N must be a power of two within the cosine tables");
+
+public:
+    typedef DspTraits<Sample> Traits;
+
+    Sample re[N];
+    Sample im[N];
+    uint16_t fftSize;   // length of the transform behind the spectrum in re[]
+    uint8_t scaleBits;  // fixed point stages halved this many times in total
+
+    TremorDsp() : fftSize(N), scaleBits(0) {}
+
+    // store a sample given as a fixed point value with fracBits fractional bits of full scale
+    void setSample(uint16_t i, int32_t value, uint8_t fracBits) {
+        re[i] = Traits::fromFixed(value, fracBits);
+    }
+
+    // Hamming window, FFT and magnitude over the whole frame
+    void transform() {
+        begin(1);
+        while (!step()) {}
+    }
+
+    /*
+    Welch power spectral density over the frame in re[]. the frame is
+    split into `segments` half-overlapping pieces of length
+    2 * N / (segments + 1), and each one is windowed and transformed
+    in im[], which is just big enough to hold one segment's real and
+    imaginary halves. re[] keeps the raw samples until every segment
+    is done, so nothing is copied aside; only the per-bin power sums
+    are kept.
+
+    the averaged power is written back into re[] as a magnitude
+    spectrum, rescaled to the N-point amplitude so the intensity
+    thresholds still apply. averaging 3 segments roughly thirds the
+    variance of the estimate at the cost of half the frequency
+    resolution.
+    */
+    void welch(uint8_t segments) {
+        begin(segments);
+        while (!step()) {}
+    }
+
+    // whether welch(segments) can run on this backend; the portable FFT takes any power of two
+    static bool supports(uint8_t) {
+        return true;
+    }
+
+    /*
+    the same two transforms, resumable. begin(1) sets up transform() and
+    begin(segments) welch(); every step() then does one bounded piece of
+    the work and returns true once the spectrum is in re[]. a piece is
+    at most dspStepItems window coefficients, butterflies, magnitudes or
+    power sums, or the bit reversal of a whole segment, so the caller
+    can stop between any two calls and pick up where it left off.
+    */
+    void begin(uint8_t segments) {
+        this->segments = segments;
+        segment = 0;
+        length = segments > 1 ? 2 * N / (segments + 1) : N;
+        if (segments > 1)
+            for (uint16_t k = 0; k <= length / 2; k++) power[k] = 0;
+        phase = PHASE_WINDOW;
+        cursor = 0;
+    }
+
+    bool step() {
+        const bool averaging = segments > 1;
+        Sample *xr = averaging ? im : re;
+        Sample *xi = averaging ? im + length : im;
+        const uint16_t bins = length / 2 + 1;
+        uint16_t end;
+        switch (phase) {
+        case PHASE_WINDOW:
+            end = cursor + dspStepItems < bins ? cursor + dspStepItems : bins;
+            window(xr, xi, re + segment * (length / 2), length, cursor, end);
+            cursor = end;
+            if (cursor == bins) phase = PHASE_REVERSE;
+            return false;
+        case PHASE_REVERSE:
+            bitReverse(xr, xi, length);
+            phase = PHASE_STAGE;
+            span = 2;
+            cursor = 0;
+            offset = 0;
+            return false;
+        case PHASE_STAGE:
+            for (uint8_t c = 0; c < dspStepItems && phase == PHASE_STAGE; c++) butterflyNext(xr, xi);
+            return false;
+        case PHASE_COLLECT:
+            end = cursor + dspStepItems < bins ? cursor + dspStepItems : bins;
+            for (uint16_t k = cursor; k < end; k++) {
+                if (averaging) power[k] += Traits::power(xr[k], xi[k]);
+                else re[k] = Traits::magnitude(re[k], im[k]);
+            }
+            cursor = end;
+            if (cursor < bins) return false;
+            cursor = 0;
+            if (!averaging) return finish();
+            phase = ++segment < segments ? PHASE_WINDOW : PHASE_AVERAGE;
+            return false;
+        case PHASE_AVERAGE:
+            end = cursor + dspStepItems < bins ? cursor + dspStepItems : bins;
+            for (uint16_t k = cursor; k < end; k++) re[k] = Traits::rootMean(power[k], segments);
+            cursor = end;
+            return cursor == bins ? finish() : false;
+        default:
+            return true;
+        }
+    }
+
+    // true between begin() and the step() that completes the spectrum
+    bool busy() const { return phase != PHASE_IDLE; }
+
+    // magnitude of bin k in m/s^2, scaled to the amplitude of an N-point transform
+    double magnitude(uint16_t k) const {
+        double m = Traits::toReal(re[k]) * dspFullScale;
+        return ldexp(m, scaleBits) * N / fftSize;
+    }
+
+    // bin of the current spectrum holding frequency `hz` at sampling rate `fs`
+    uint16_t binFor(double hz, double fs) const {
+        return hz * fftSize / fs + 0.5;
+    }
+
+    // largest magnitude between lowHz and highHz, DC and Nyquist excluded
+    double bandPeak(double lowHz, double highHz, double fs) const {
+        uint16_t bin = peakBin(lowHz, highHz, fs);
+        return bin ? magnitude(bin) : 0;
+    }
+
+    // bin of that largest magnitude (the first one on a tie), 0 if the band is empty or silent
+    uint16_t peakBin(double lowHz, double highHz, double fs) const {
+        double peak = 0;
+        uint16_t bin = 0;
+        for (uint16_t i = 1; i < fftSize / 2; i++) {
+            double frequency = i * fs / fftSize;
+            if (frequency >= lowHz && frequency <= highHz) {
+                double m = magnitude(i);
+                if (m > peak) {
+                    peak = m;
+                    bin = i;
+                }
+            }
+        }
+        return bin;
+    }
+
+protected:
+    enum Phase : uint8_t { PHASE_IDLE, PHASE_WINDOW, PHASE_REVERSE, PHASE_STAGE, PHASE_COLLECT, PHASE_AVERAGE };
+
+    Accum power[N / 4 + 1];  // running Welch power sums, enough for 64-point segments
+    // where begin() / step() are up to
+    uint8_t phase = PHASE_IDLE;
+    uint8_t segments = 1, segment = 0;
+    uint16_t length = N;  // points per transform
+    uint16_t cursor = 0;  // next bin, or the butterfly's twiddle index within a stage
+    uint16_t span = 2;    // butterfly stage length
+    uint16_t offset = 0;  // first point of the butterfly group within the stage
+
+    bool finish() {
+        fftSize = length;
+        scaleBits = Traits::stageShift * bitsOf(length);
+        phase = PHASE_IDLE;
+        return true;
+    }
+
+    static uint8_t bitsOf(uint16_t n) {
+        uint8_t bits = 0;
+        while (n > 1) {
+            n >>= 1;
+            bits++;
+        }
+        return bits;
+    }
+
+    // cos(2 pi j / dspTablePoints) for j = 0 .. dspTablePoints / 2, from the quarter wave table
+    static Sample cosTurn(uint16_t j) {
+        const uint16_t quarter = dspTablePoints / 4;
+        return j <= quarter ? Traits::fromTable(j) : -Traits::fromTable(dspTablePoints / 2 - j);
+    }
+
+    /*
+    periodic Hamming window, 0.54 - 0.46 cos(2 pi i / n). it is even
+    about n / 2 (w[i] = w[n - i]), so each coefficient serves two
+    samples and only the half turn of the cosine table is needed.
+    */
+    static void window(Sample *x, uint16_t n) {
+        const uint16_t stride = dspTablePoints / n;
+        for (uint16_t i = 0; i <= n / 2; i++) {
+            Sample w = Traits::hamming(cosTurn(i * stride));
+            x[i] = Traits::mul(x[i], w);
+            if (i > 0 && i < n / 2) x[n - i] = Traits::mul(x[n - i], w);
+        }
+    }
+
+    // coefficients from .. to - 1 of the window over src[] into xr[] (src may be xr), clearing xi[]
+    static void window(Sample *xr, Sample *xi, const Sample *src, uint16_t n, uint16_t from, uint16_t to) {
+        const uint16_t stride = dspTablePoints / n;
+        for (uint16_t i = from; i < to; i++) {
+            Sample w = Traits::hamming(cosTurn(i * stride));
+            xr[i] = Traits::mul(src[i], w);
+            xi[i] = 0;
+            if (i > 0 && i < n / 2) {
+                xr[n - i] = Traits::mul(src[n - i], w);
+                xi[n - i] = 0;
+            }
+        }
+    }
+
+    // w = exp(-2 pi i k / len); j stays below half a turn, so sin(j) = cos(|j - quarter|)
+    static void twiddle(uint16_t k, uint16_t len, Sample &wr, Sample &wi) {
+        const uint16_t quarter = dspTablePoints / 4;
+        uint16_t j = k * (dspTablePoints / len);
+        wr = cosTurn(j);
+        wi = -Traits::fromTable(j <= quarter ? quarter - j : j - quarter);
+    }
+
+    static void bitReverse(Sample *xr, Sample *xi, uint16_t n) {
+        for (uint16_t i = 0, j = 0; i < n - 1; i++) {
+            if (i < j) {
+                Sample t = xr[i]; xr[i] = xr[j]; xr[j] = t;
+                t = xi[i]; xi[i] = xi[j]; xi[j] = t;
+            }
+            uint16_t k = n >> 1;
+            while (k <= j) {
+                j -= k;
+                k >>= 1;
+            }
+            j += k;
+        }
+    }
+
+    // one butterfly of the current stage, then on to the next group, twiddle or stage
+    void butterflyNext(Sample *xr, Sample *xi) {
+        const uint16_t half = span >> 1;
+        Sample wr, wi;
+        twiddle(cursor, span, wr, wi);
+        const uint16_t i = offset + cursor;
+        Traits::butterfly(xr[i], xi[i], xr[i + half], xi[i + half], wr, wi);
+        offset += span;
+        if (offset < length) return;
+        offset = 0;
+        if (++cursor < half) return;
+        cursor = 0;
+        span <<= 1;
+        if (span > length) phase = PHASE_COLLECT;
+    }
+};
+
+#endif
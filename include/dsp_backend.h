@@ -0,0 +1,29 @@
+#ifndef DSP_BACKEND_H
+#define DSP_BACKEND_H
+
+#include "dsp.h"
+#ifdef DSP_BACKEND_CMSIS
+#include "dsp_cmsis.h"
+#endif
+
+/*
+the DSP the sketch is built with, picked by -D DSP_BACKEND_CMSIS and
+-D DSP_SAMPLE_T. modules that need to know what it can do (params.cpp
+asks SketchDsp::supports()) include this rather than main.cpp's
+instance.
+*/
+
+// numeric type of the DSP path: float, double, int16_t (Q15) or int32_t (Q31)
+#ifndef DSP_SAMPLE_T
+#define DSP_SAMPLE_T double
+#endif
+
+const uint16_t samples = 128;  // analysis frame length
+
+#ifdef DSP_BACKEND_CMSIS
+typedef CmsisTremorDsp<DSP_SAMPLE_T, samples> SketchDsp;  // float or int16_t only
+#else
+typedef TremorDsp<DSP_SAMPLE_T, samples> SketchDsp;
+#endif
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef DSP_CMSIS_H
+#define DSP_CMSIS_H
+
+#include <arm_math.h>
+#include "dsp.h"
+
+/*
+CMSIS-DSP backend for the Cortex-M0+ (SAMD21, Circuit Playground
+Express). same interface as TremorDsp, but the transform is the
+library's real FFT: arm_rfft_fast_f32 for float, arm_rfft_q15 for Q15.
+windowing, Welch averaging, magnitude() and bandPeak() are shared with
+the portable path, so outputs can be compared bin for bin in
+tools/dsp_bench (make CMSIS_DSP=<path> for the host build of the same
+kernels).
+
+RAM is not scarce on the SAMD21, so the backend keeps its own output
+buffer instead of squeezing the real FFT into im[]. the library kernels
+cannot be paused, so begin() / step() run the whole transform in the
+first step; at 48 MHz that is well inside one sampling period.
+*/
+
+template <typename Sample, uint16_t N> class CmsisTremorDsp;
+
+template <uint16_t N> class CmsisTremorDsp<float, N> : public TremorDsp<float, N> {
+public:
+    typedef TremorDsp<float, N> Base;
+
+    void begin(uint8_t segments) {
+        this->segments = segments;
+        this->phase = Base::PHASE_WINDOW;
+    }
+
+    bool step() {
+        if (this->segments > 1) welch(this->segments);
+        else transform();
+        this->phase = Base::PHASE_IDLE;
+        return true;
+    }
+
+    void transform() {
+        Base::window(this->re, N);
+        rfft(this->re, N);
+        fftSizeIs(N);
+    }
+
+    void welch(uint8_t segments) {
+        const uint16_t length = 2 * N / (segments + 1);
+        const uint16_t bins = length / 2 + 1;
+        for (uint16_t k = 0; k < bins; k++) this->power[k] = 0;
+        for (uint8_t s = 0; s < segments; s++) {
+            for (uint16_t i = 0; i < length; i++) this->im[i] = this->re[s * length / 2 + i];
+            Base::window(this->im, length);
+            rfft(this->im, length);
+            for (uint16_t k = 0; k < bins; k++) this->power[k] += this->im[k] * this->im[k];
+        }
+        for (uint16_t k = 0; k < bins; k++) this->re[k] = sqrtf(this->power[k] / segments);
+        fftSizeIs(length);
+    }
+
+    // arm_rfft_fast_f32 takes 32 to 4096 points, so 16 point segments are out
+    static bool supports(uint8_t segments) {
+        uint16_t length = 2 * N / (segments + 1);
+        return length >= 32 && length <= 4096;
+    }
+
+private:
+    float out[N];
+
+    // magnitudes of an n point real FFT of x, written back over x[0..n/2]
+    void rfft(float *x, uint16_t n) {
+        arm_rfft_fast_instance_f32 s;
+        if (arm_rfft_fast_init_f32(&s, n) != ARM_MATH_SUCCESS) {
+            // a length the library has no tables for; supports() keeps params from asking
+            for (uint16_t k = 0; k <= n / 2; k++) x[k] = 0;
+            return;
+        }
+        arm_rfft_fast_f32(&s, x, out, 0);
+        // out[0] is DC and out[1] Nyquist (both real), then re/im pairs for bins 1..n/2-1
+        x[0] = fabsf(out[0]);
+        x[n / 2] = fabsf(out[1]);
+        arm_cmplx_mag_f32(out + 2, x + 1, n / 2 - 1);
+    }
+
+    void fftSizeIs(uint16_t n) {
+        this->fftSize = n;
+        this->scaleBits = 0;
+    }
+};
+
+template <uint16_t N> class CmsisTremorDsp<int16_t, N> : public TremorDsp<int16_t, N> {
+public:
+    typedef TremorDsp<int16_t, N> Base;
+
+    void begin(uint8_t segments) {
+        this->segments = segments;
+        this->phase = Base::PHASE_WINDOW;
+    }
+
+    bool step() {
+        if (this->segments > 1) welch(this->segments);
+        else transform();
+        this->phase = Base::PHASE_IDLE;
+        return true;
+    }
+
+    void transform() {
+        Base::window(this->re, N);
+        rfft(this->re, N);
+        fftSizeIs(N);
+    }
+
+    void welch(uint8_t segments) {
+        typedef DspTraits<int16_t> Traits;
+        const uint16_t length = 2 * N / (segments + 1);
+        const uint16_t bins = length / 2 + 1;
+        for (uint16_t k = 0; k < bins; k++) this->power[k] = 0;
+        for (uint8_t s = 0; s < segments; s++) {
+            for (uint16_t i = 0; i < length; i++) this->im[i] = this->re[s * length / 2 + i];
+            Base::window(this->im, length);
+            rfft(this->im, length);
+            // rfft left magnitudes, so the power of bin k is mag^2 with a zero imaginary part
+            for (uint16_t k = 0; k < bins; k++) this->power[k] += Traits::power(this->im[k], 0);
+        }
+        for (uint16_t k = 0; k < bins; k++) this->re[k] = Traits::rootMean(this->power[k], segments);
+        fftSizeIs(length);
+    }
+
+    // CMSIS 4.5's arm_rfft_q15 only has tables for 128, 512, 2048 and 8192 points
+    static bool supports(uint8_t segments) {
+        uint16_t length = 2 * N / (segments + 1);
+        return length == 128 || length == 512 || length == 2048 || length == 8192;
+    }
+
+private:
+    q15_t out[2 * N];  // arm_rfft_q15 writes the full conjugate-symmetric spectrum
+
+    void rfft(int16_t *x, uint16_t n) {
+        arm_rfft_instance_q15 s;
+        if (arm_rfft_init_q15(&s, n, 0, 1) != ARM_MATH_SUCCESS) {
+            for (uint16_t k = 0; k <= n / 2; k++) x[k] = 0;
+            return;
+        }
+        arm_rfft_q15(&s, x, out);
+        arm_cmplx_mag_q15(out, x, n / 2 + 1);
+    }
+
+    /*
+    arm_rfft_q15 returns X scaled down by n/2 (7.9 format for 128
+    points, 6.10 for 64) and arm_cmplx_mag_q15 answers in 2.14, so the
+    magnitudes are X / n in Q15 terms, the same log2(n) shift the
+    portable fixed point FFT ends up with.
+    */
+    void fftSizeIs(uint16_t n) {
+        this->fftSize = n;
+        this->scaleBits = Base::bitsOf(n);
+    }
+};
+
+#endif
@@ -0,0 +1,73 @@
+// generated by scripts/gen_tables.py, do not edit
+#ifndef DSP_TABLES_H
+#define DSP_TABLES_H
+
+#include <stdint.h>
+#if defined(__AVR__) || defined(ARDUINO_ARCH_SAMD)
+#include <avr/pgmspace.h>
+#else
+// host builds: tables are ordinary constants (same spelling as lib/ArduinoSim)
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_word
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#endif
+#ifndef pgm_read_dword
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#endif
+#ifndef pgm_read_float
+#define pgm_read_float(p) (*(const float *)(p))
+#endif
+#endif
+
+// cos(2 * pi * i / dspTablePoints) for the first quarter turn, i = 0 .. dspTablePoints / 4
+const uint16_t dspTablePoints = 128;
+
+const float dspCosFloat[33] PROGMEM = {
+    1.0f, 0.998795456f, 0.995184727f, 0.98917651f, 0.98078528f, 0.970031253f,
+    0.956940336f, 0.941544065f, 0.923879533f, 0.903989293f, 0.881921264f, 0.85772861f,
+    0.831469612f, 0.803207531f, 0.773010453f, 0.740951125f, 0.707106781f, 0.671558955f,
+    0.634393284f, 0.595699304f, 0.555570233f, 0.514102744f, 0.471396737f, 0.427555093f,
+    0.382683432f, 0.336889853f, 0.290284677f, 0.24298018f, 0.195090322f, 0.146730474f,
+    0.0980171403f, 0.0490676743f, 0.0f,
+};
+
+const double dspCosDouble[33] PROGMEM = {
+    1.0, 0.99879545620517241, 0.99518472667219693, 0.98917650996478101,
+    0.98078528040323043, 0.97003125319454397, 0.95694033573220882, 0.94154406518302081,
+    0.92387953251128674, 0.90398929312344334, 0.88192126434835505, 0.85772861000027212,
+    0.83146961230254524, 0.80320753148064494, 0.77301045336273699, 0.74095112535495911,
+    0.70710678118654757, 0.67155895484701833, 0.63439328416364549, 0.59569930449243347,
+    0.55557023301960229, 0.51410274419322166, 0.47139673682599781, 0.4275550934302822,
+    0.38268343236508984, 0.33688985339222005, 0.29028467725446233, 0.24298017990326398,
+    0.19509032201612833, 0.14673047445536175, 0.09801714032956077, 0.049067674327418126,
+    0.0,
+};
+
+const int16_t dspCosQ15[33] PROGMEM = {
+    32767, 32729, 32610, 32413, 32138, 31786, 31357, 30853, 30274, 29622,
+    28899, 28106, 27246, 26320, 25330, 24279, 23170, 22006, 20788, 19520,
+    18205, 16846, 15447, 14010, 12540, 11039, 9512, 7962, 6393, 4808,
+    3212, 1608, 0,
+};
+
+const int32_t dspCosQ31[33] PROGMEM = {
+    2147483647L, 2144896910L, 2137142927L, 2124240380L, 2106220352L, 2083126254L,
+    2055013723L, 2021950484L, 1984016189L, 1941302225L, 1893911494L, 1841958164L,
+    1785567396L, 1724875040L, 1660027308L, 1591180426L, 1518500250L, 1442161874L,
+    1362349204L, 1279254516L, 1193077991L, 1104027237L, 1012316784L, 918167572L,
+    821806413L, 723465451L, 623381598L, 521795963L, 418953276L, 315101295L,
+    210490206L, 105372028L, 0L,
+};
+
+// double is a 4 byte float on AVR, where flash must be read explicitly
+inline double dspReadDouble(const double *p) {
+#ifdef __AVR__
+    return pgm_read_float(p);
+#else
+    return *p;
+#endif
+}
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef FEEDBACK_H
+#define FEEDBACK_H
+
+#include <stdint.h>
+
+/*
+Neopixel feedback levels with hysteresis. the per-frame intensity
+jitters around lowThreshold and highThreshold, and every level change
+costs a full rewrite of the pixels with interrupts off. so a boundary
+is only crossed once the intensity is feedbackMargin past its
+threshold in the direction of travel, and a new level is only shown
+after feedbackDwellFrames frames in a row have asked for it.
+*/
+
+enum FeedbackLevel { FEEDBACK_GREEN, FEEDBACK_YELLOW, FEEDBACK_RED, FEEDBACK_NONE = 0xFF };
+
+const double feedbackMargin = 3.0;     // intensity past a threshold before its boundary is crossed
+const uint8_t feedbackDwellFrames = 2; // frames a new level must persist before it is shown
+
+struct FeedbackState {
+    uint8_t shown = FEEDBACK_NONE;    // level on the pixels
+    uint8_t pending = FEEDBACK_NONE;  // level asked for by the last frames
+    uint8_t count = 0;                // consecutive frames asking for pending
+};
+
+// the level an intensity asks for, with the boundaries pushed away from the level shown
+inline uint8_t feedbackCandidate(double intensity, double low, double high, uint8_t shown) {
+    double lowEdge = low, highEdge = high;
+    if (shown != FEEDBACK_NONE) {
+        lowEdge += shown == FEEDBACK_GREEN ? feedbackMargin : -feedbackMargin;
+        highEdge += shown == FEEDBACK_RED ? -feedbackMargin : feedbackMargin;
+    }
+    if (intensity >= highEdge) return FEEDBACK_RED;
+    return intensity >= lowEdge ? FEEDBACK_YELLOW : FEEDBACK_GREEN;
+}
+
+// one frame's intensity; true when s.shown changed and the pixels need redrawing
+inline bool feedbackUpdate(FeedbackState &s, double intensity, double low, double high) {
+    uint8_t want = feedbackCandidate(intensity, low, high, s.shown);
+    if (want == s.shown) {
+        s.count = 0;
+        return false;
+    }
+    if (s.shown != FEEDBACK_NONE) {  // the first frame after a reset is shown at once
+        if (want != s.pending) {
+            s.pending = want;
+            s.count = 0;
+        }
+        if (++s.count < feedbackDwellFrames) return false;
+    }
+    s.shown = want;
+    s.count = 0;
+    return true;
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+
+/*
+on-device intensity history. every minute the rollup module closes is
+kept as its frame count, mean and peak intensity (whole units), with
+the mean and peak stored as zig-zag varint deltas from the previous
+minute: a steady trend costs 3 bytes a minute. minutes without frames
+(device stopped) collapse into a single gap entry.
+
+entries collect in a RAM block that is written to EEPROM every
+historyFlushMinutes and whenever it fills up. the EEPROM past the
+calibration ring holds a ring of these blocks; each one starts its
+delta chain from zero so it decodes on its own, and the oldest is
+overwritten once the ring is full. on the ATmega32u4 that is 22 blocks,
+about 3 hours of wear time. a flush only rewrites the bytes that
+changed, so a block's cells see a handful of writes.
+
+an AVR EEPROM write takes about 3.4 ms, so a flush does not write the
+block in one go: historyPoll(), called every ui slice, writes at most
+one changed byte, data before header so the stored used count never
+covers bytes that are not there yet. a full block stays in RAM until it
+is all in EEPROM; the minute that did not fit is held back until then.
+
+  block: magic | flags | sequence lo | sequence hi | used | used data bytes
+  entry: varint frames, then zig-zag varint mean and peak deltas,
+         or frames 0 and a varint count of empty minutes
+*/
+
+const uint8_t historyBlockSize = 32;
+const uint8_t historyFlushMinutes = 5;
+
+// find the newest stored block and start a new one after it
+void historyBegin();
+// one closed minute (see rollup.h); frames 0 for a minute without any
+void historyMinute(uint16_t frames, uint16_t mean, uint16_t peak);
+// start writing the block to EEPROM; historyPoll() does the writing
+void historyFlush();
+void historyPoll();
+// every stored minute over Serial, oldest first
+void historyDump();
+// invalidate every stored block
+void historyClear();
+
+#endif
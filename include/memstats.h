@@ -0,0 +1,27 @@
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include <stdint.h>
+
+/*
+SRAM accounting for the 2.5 KB ATmega32u4. the free region between
+the heap and the stack is painted with a known byte at boot (before
+main() runs), so a later scan can tell how deep the stack has ever
+reached. on non-AVR builds every value reads back as 0.
+*/
+
+// bytes taken by .data and .bss (globals such as the DSP frame and library buffers)
+uint16_t memstatsStaticBytes();
+// bytes currently free between the heap top and the stack pointer
+uint16_t memstatsFreeNow();
+// smallest free gap ever observed (never-touched painted bytes), updated by memstatsScan()
+uint16_t memstatsMinFree();
+// deepest stack usage observed so far in bytes
+uint16_t memstatsStackPeak();
+
+// walk the painted region and refresh the high-water mark
+void memstatsScan();
+// print the current figures over Serial
+void memstatsReport();
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <stdint.h>
+
+/*
+detection and display thresholds that can be changed while the device
+runs. the pipeline only ever reads `params`; edits are made on a
+pending copy, validated, and swapped in by paramsApplyPending() between
+frames so a frame is never analyzed with a half-updated set.
+*/
+struct TuningParams {
+    double dangerZoneIntensity;      // per-frame intensity counted as dangerous
+    double dangerRatio;              // fraction of dangerous sample sets that sounds the alarm
+    unsigned long sampleInterval;    // interval for each sample set in milliseconds
+    unsigned long evaluationPeriod;  // total period for evaluation in milliseconds
+    double lowThreshold;             // green/yellow boundary of the Neopixel display
+    double highThreshold;            // yellow/red boundary of the Neopixel display
+    double bandLowHz;                // tremor band searched by analyzeFFT()
+    double bandHighHz;
+    uint8_t welchSegments;           // 1 = single periodogram, 3/7/15 = Welch averages per frame
+};
+
+extern const TuningParams defaultParams;
+extern TuningParams params;
+
+bool paramsValid(const TuningParams &p);
+// copy of what the next swap will install (the active set when nothing is pending)
+TuningParams paramsPending();
+// validate and queue a new set, false (and nothing queued) if it is rejected
+bool paramsStage(const TuningParams &p);
+// install a queued set, returns true if one was applied
+bool paramsApplyPending();
+
+#endif
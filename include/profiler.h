@@ -0,0 +1,50 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+/*
+per-stage cycle profiler. Timer1 free-runs at the CPU clock and an
+overflow interrupt extends it to 32 bits, so every stage is measured in
+real CPU cycles (16 per microsecond on the Circuit Playground Classic).
+
+build with -D ENABLE_PROFILER to compile it in. without the flag
+PROFILE_STAGE() expands to nothing and none of this code is linked.
+*/
+
+enum ProfileStage {
+    STAGE_BUTTONS,
+    STAGE_COLLECT,
+    STAGE_FFT,
+    STAGE_ANALYZE,
+    STAGE_FEEDBACK,
+    STAGE_COUNT
+};
+
+#ifdef ENABLE_PROFILER
+
+void profilerBegin();
+uint32_t profilerCycles();
+void profilerRecord(uint8_t stage, uint32_t cycles);
+void profilerReset();
+void profilerDump();
+
+// records the cycles between its construction and the end of the enclosing scope
+class ProfileScope {
+public:
+    explicit ProfileScope(uint8_t stage) : stage(stage), start(profilerCycles()) {}
+    ~ProfileScope() { profilerRecord(stage, profilerCycles() - start); }
+private:
+    uint8_t stage;
+    uint32_t start;
+};
+
+#define PROFILE_STAGE(stage) ProfileScope profileScope_(stage)
+
+#else
+
+#define PROFILE_STAGE(stage) do {} while (0)
+
+#endif
+
+#endif
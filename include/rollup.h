@@ -0,0 +1,63 @@
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <stdint.h>
+
+class __FlashStringHelper;  // F() strings, from the Arduino core
+
+/*
+multi-resolution tremor aggregates, maintained as frames arrive. every
+analyzed frame goes into the open minute; a closed minute is pushed
+into the minute ring and merged into the open hour, a closed hour into
+the hour ring and the open day, a closed day into the day ring. each
+level keeps a fixed ring of its most recent closed units, so memory
+does not grow with wear time and nothing needs the raw frames.
+
+an aggregate is mergeable: counts and sums add, the peak keeps the
+larger one along with the dominant frequency of the frame it came from.
+rollupQuery() answers "the last N minutes" by walking down from now:
+the open minute, then either enough closed units of one level or the
+whole open unit of the next level up, so the work is a few entries per
+level. a range that starts inside an older unit is rounded out to the
+whole unit (the answer says how many minutes it covers).
+
+minutes are counted on millis() since boot; closed minutes are also
+handed to the EEPROM history (history.h).
+*/
+
+struct RollupEntry {
+    uint32_t frames;
+    uint32_t dangerFrames;  // intensity at or above dangerZoneIntensity
+    uint32_t intensitySum;  // whole intensity units
+    uint16_t peak;          // whole intensity units
+    uint8_t peakHz10;       // dominant frequency of the peak frame, 0.1 Hz
+};
+
+enum RollupLevel { ROLLUP_MINUTE, ROLLUP_HOUR, ROLLUP_DAY, ROLLUP_LEVELS };
+
+// closed units kept per level; the ATmega32u4's 2.5 KB of RAM only affords short rings
+// (13 entries, 195 bytes): the last 5 minutes, 6 hours and 2 days. the host checks
+// build with ROLLUP_AVR_RINGS to walk the same sizes
+#if defined(__AVR__) || defined(ROLLUP_AVR_RINGS)
+const uint8_t rollupMinutes = 5, rollupHours = 6, rollupDays = 2;
+#else
+const uint8_t rollupMinutes = 60, rollupHours = 48, rollupDays = 30;
+#endif
+const uint8_t rollupRing[ROLLUP_LEVELS] = {rollupMinutes, rollupHours, rollupDays};
+// minutes in one unit of each level, and units of a level per unit of the next
+const uint16_t rollupSpan[ROLLUP_LEVELS] = {1, 60, 1440};
+const uint8_t rollupPer[ROLLUP_LEVELS] = {60, 24, 0};
+
+void rollupBegin();
+void rollupFrame(double intensity, double dominantHz, bool danger);
+// closes the minute on time; call often
+void rollupPoll();
+// aggregate over about the last `minutes`; returns the minutes it covers
+uint32_t rollupQuery(uint32_t minutes, RollupEntry &out);
+// closed day `back` days ago (1 = yesterday), false if not kept
+bool rollupDay(uint8_t back, RollupEntry &out);
+// today so far
+void rollupToday(RollupEntry &out);
+void rollupPrint(const __FlashStringHelper *label, const RollupEntry &e);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+/*
+static cooperative scheduler. the sketch's work is a fixed table of
+tasks in priority order (highest first); loop() only calls
+schedulerRun(), which keeps dispatching the highest priority ready task
+until nothing is ready.
+
+a task is run one slice at a time: its function does a bounded piece of
+work and returns true if it has more to do, in which case it stays
+ready and is called again. because the table is scanned from the top
+before every slice, a higher priority task (sampling) never waits
+longer than the longest single slice of anything below it.
+
+periodic tasks are released every periodUs on a fixed grid; event tasks
+(periodUs 0) are released by schedulerRelease(), typically from another
+task. a slice that starts more than deadlineUs after its task's release
+is counted as a deadline miss. a periodic task that falls a whole period
+behind skips the releases it missed instead of running them back to
+back.
+*/
+
+typedef bool (*TaskSlice)();
+
+// the table lives in flash; the scheduler reads its fields with pgm_read_*()
+struct Task {
+    char name[10];
+    TaskSlice run;
+    uint32_t periodUs;    // 0 for an event task
+    uint32_t deadlineUs;  // allowed delay from release to the first slice
+};
+
+const uint8_t schedulerMaxTasks = 8;
+
+// the sketch's task table in priority order, defined in main.cpp (PROGMEM)
+extern const Task tasks[];
+extern const uint8_t taskCount;
+
+void schedulerBegin();
+void schedulerRun();
+void schedulerRelease(uint8_t task);
+// true while the task is released and has not finished
+bool schedulerPending(uint8_t task);
+// micros() at which the task's current (or next) release fell due
+uint32_t schedulerReleaseTime(uint8_t task);
+void schedulerReset();
+void schedulerReport();
+
+#endif
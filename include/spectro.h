@@ -0,0 +1,67 @@
+#ifndef SPECTRO_H
+#define SPECTRO_H
+
+#include <stdint.h>
+#include <math.h>
+
+/*
+band-limited spectrogram stream. when enabled, every analyzed frame is
+sent as one binary packet holding bins 6-20 of the 128-point spectrum
+(2.3-7.8 Hz at 50 Hz sampling) as 8-bit log magnitudes:
+
+  0xA5 0x5A | type | seq lo | seq hi | count | count bytes | crc8
+
+the CRC covers type through the last bin byte. packets share the serial
+line with the text telemetry, so receivers hunt for the sync pair and
+drop anything that fails the CRC. at one 21 byte packet per frame the
+stream costs well under a hundred bytes per second.
+
+this header is also compiled into the host receiver (tools/), so the
+constants and the (de)quantization live here.
+*/
+
+const uint8_t spectroSync0 = 0xA5;
+const uint8_t spectroSync1 = 0x5A;
+const uint8_t spectroTypeFrame = 0x01;
+const uint8_t spectroFirstBin = 6;
+const uint8_t spectroLastBin = 20;
+const uint8_t spectroBins = spectroLastBin - spectroFirstBin + 1;
+const uint8_t spectroLogScale = 32;  // codes per doubling of magnitude
+const uint8_t spectroPacketSize = 2 + 4 + spectroBins + 1;
+
+// q = 32 * log2(1 + magnitude), saturating at 255 (magnitude ~250)
+inline uint8_t spectroQuantize(double magnitude) {
+    if (magnitude <= 0) return 0;
+    double q = spectroLogScale * log(1 + magnitude) / log(2.0) + 0.5;
+    return q >= 255 ? 255 : (uint8_t)q;
+}
+
+inline double spectroDequantize(uint8_t q) {
+    return pow(2.0, (double)q / spectroLogScale) - 1;
+}
+
+// CRC-8, polynomial 0x07
+inline uint8_t spectroCrc8(const uint8_t *data, uint8_t length) {
+    uint8_t crc = 0;
+    while (length--) {
+        crc ^= *data++;
+        for (uint8_t i = 0; i < 8; i++) crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+/*
+bin of an fftSize point spectrum holding packet bin i; shorter (Welch)
+transforms are read at the matching frequency so a packet always
+describes the same 128-point bins.
+*/
+inline uint16_t spectroSourceBin(uint8_t i, uint16_t fftSize) {
+    return (uint32_t)(spectroFirstBin + i) * fftSize / 128;
+}
+
+extern bool spectroStreaming;
+
+// send one packet of spectroBins quantized magnitudes
+void spectroSend(const uint8_t *bins);
+
+#endif
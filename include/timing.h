@@ -0,0 +1,43 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+
+/*
+sampling quality monitor. the acquire task reports every sample with
+the time the scheduler released it and the time it was actually
+taken; the difference (lateness) goes into a histogram, samples a
+period and a half or more apart count the periods between them as
+missed, and each completed frame gets an effective sample rate and a
+verdict.
+
+a frame is suspect when it missed a sample or any of its samples came
+more than timingLateUs late: its bins no longer sit at the frequencies
+analyzeFFT() assumes, so its intensity should not count towards the
+alarm. overruns are frames the analysis never got to because the next
+one completed first.
+*/
+
+const uint8_t timingBins = 8;
+const uint32_t timingLateUs = 5000;  // a quarter of the 20 ms sampling period
+const uint16_t resampleLateUs = 250;  // readings later than this are interpolated back onto the grid
+
+// upper lateness bounds of the histogram bins in us; the last bin takes the rest
+extern const uint16_t timingBinEdges[timingBins - 1];
+
+void timingBegin(uint32_t periodUs);
+// sampling stopped; the next sample starts a new sequence instead of a gap,
+// and a new frame (the acquire task drops its partial frame too)
+void timingRestart();
+void timingSample(uint32_t releaseUs, uint32_t takenUs);
+// the reading taken at takenUs as it would have been at gridUs (see timing.cpp)
+int32_t alignToGrid(int32_t reading, uint32_t gridUs, uint32_t takenUs);
+// close the current frame; true if its timing can be trusted
+bool timingFrameEnd();
+void timingOverrun();
+// samples per second over the last completed frame
+double timingSampleRate();
+void timingReset();
+void timingReport();
+
+#endif
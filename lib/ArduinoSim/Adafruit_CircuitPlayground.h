@@ -0,0 +1,28 @@
+#ifndef ARDUINO_SIM_CIRCUITPLAYGROUND_H
+#define ARDUINO_SIM_CIRCUITPLAYGROUND_H
+
+#include "Arduino.h"
+
+#define CPLAY_BUZZER 5  // the Classic's speaker pin, for tone() / noTone()
+
+// Circuit Playground stand-in: accelerometer and buttons come from the replay
+class SimCircuitPlayground {
+public:
+    bool begin() { return true; }
+    float motionX() { return simMotion().x; }
+    float motionY() { return simMotion().y; }
+    float motionZ() { return simMotion().z; }
+    bool leftButton() { return simLeftPressed(); }
+    bool rightButton() { return simRightPressed(); }
+    bool slideSwitch() { return simSlideSwitch(); }
+    void playTone(uint16_t freq, uint16_t ms, bool wait = true) {
+        simTone(freq, ms);
+        if (wait) simAdvance((uint64_t)ms * 1000);
+    }
+    void setPixelColor(uint8_t n, uint8_t r, uint8_t g, uint8_t b) { simPixel(n, r, g, b); }
+    void clearPixels() { simClearPixels(); }
+};
+
+extern SimCircuitPlayground CircuitPlayground;
+
+#endif
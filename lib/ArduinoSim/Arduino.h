@@ -0,0 +1,77 @@
+#ifndef ARDUINO_SIM_ARDUINO_H
+#define ARDUINO_SIM_ARDUINO_H
+
+/*
+the parts of the Arduino core the sketch uses, backed by the simulator.
+types keep their host widths (unsigned long is 64 bits here), but
+micros() and millis() are cut to 32 bits like the device's, so micros()
+wraps after ~71 minutes of virtual time and the sketch's wraparound
+arithmetic gets exercised.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include "sim.h"
+
+using std::max;
+using std::min;
+
+// flash and RAM are one address space here, so the _P variants are the plain ones
+class __FlashStringHelper;
+typedef const char *PGM_P;
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(PSTR(s)))
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define pgm_read_float(p) (*(const float *)(p))
+#define pgm_read_ptr(p) (*(void *const *)(p))
+#define memcpy_P(d, s, n) memcpy((d), (s), (n))
+#define strcmp_P(a, b) strcmp((a), (b))
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+inline uint32_t micros() { return (uint32_t)simNow(); }
+inline uint32_t millis() { return (uint32_t)(simNow() / 1000); }
+inline void delay(unsigned long ms) { simAdvance((uint64_t)ms * 1000); }
+inline void delayMicroseconds(unsigned int us) { simAdvance(us); }
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline void tone(uint8_t, unsigned int freq, unsigned long ms = 0) { simTone(freq, ms); }
+inline void noTone(uint8_t) { simTone(0, 0); }
+
+class SimSerial {
+public:
+    void begin(unsigned long) {}
+    int available() { return simSerialAvailable(); }
+    int read() { return simSerialRead(); }
+    operator bool() const { return true; }
+
+    size_t write(uint8_t b) { simSerialWrite(&b, 1); return 1; }
+    size_t write(const uint8_t *data, size_t length) { simSerialWrite(data, length); return length; }
+
+    size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+    size_t print(const __FlashStringHelper *s) { return print(reinterpret_cast<const char *>(s)); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int n, int base = 10) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = 10) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = 10);
+    size_t print(unsigned long n, int base = 10);
+    size_t print(unsigned char n, int base = 10) { return print((unsigned long)n, base); }
+    size_t print(double d, int digits = 2);
+
+    size_t println() { return print("\r\n"); }
+    template <typename T> size_t println(T v) { size_t n = print(v); return n + println(); }
+    template <typename T> size_t println(T v, int f) { size_t n = print(v, f); return n + println(); }
+};
+
+extern SimSerial Serial;
+
+#endif
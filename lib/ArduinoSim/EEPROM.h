@@ -0,0 +1,33 @@
+#ifndef ARDUINO_SIM_EEPROM_H
+#define ARDUINO_SIM_EEPROM_H
+
+#include <stdint.h>
+#include <string.h>
+
+// 1 KB EEPROM of the ATmega32u4, erased to 0xFF; --eeprom keeps it in a file between runs
+class SimEEPROM {
+public:
+    static const uint16_t size = 1024;
+    uint8_t cells[size];
+    uint32_t writes = 0;
+
+    SimEEPROM() { memset(cells, 0xFF, size); }
+    uint8_t read(int addr) { return cells[addr]; }
+    void write(int addr, uint8_t v) { cells[addr] = v; writes++; }
+    void update(int addr, uint8_t v) { if (cells[addr] != v) write(addr, v); }
+    uint16_t length() { return size; }
+
+    template <typename T> T &get(int addr, T &t) {
+        memcpy(&t, cells + addr, sizeof(T));
+        return t;
+    }
+    template <typename T> const T &put(int addr, const T &t) {
+        const uint8_t *p = (const uint8_t *)&t;
+        for (size_t i = 0; i < sizeof(T); i++) update(addr + i, p[i]);
+        return t;
+    }
+};
+
+extern SimEEPROM EEPROM;
+
+#endif
@@ -0,0 +1,334 @@
+/*
+simulator driver: option parsing, the replay source, the event queue
+and the virtual clock, plus main() which runs setup() and loop().
+
+    program [options] [trace.csv]
+
+trace lines are "t_us,x,y,z[,label]" accelerometer samples (m/s^2) in
+time order, with "@t_us,left", "@t_us,right", "@t_us,switch,0|1" and
+"@t_us,serial,<command>" events mixed in; '#' starts a comment. the
+label column is ground truth for offline scoring and is ignored here.
+without a trace a synthetic tremor is generated.
+
+    --duration S        stop after S seconds of virtual time
+    --tremor HZ AMP     synthetic input: AMP m/s^2 sine at HZ along gravity
+    --period US         accelerometer sample period the idle jump aims for (20000)
+    --press-left S      press the left button at S seconds (default 0.5; -1 = never)
+    --serial S CMD      type CMD into the console at S seconds
+    --eeprom FILE       load EEPROM from FILE and write it back at exit
+    --raw               pass serial output through byte for byte (e.g. into spectro_rx)
+    --quiet             suppress serial output, only print the summary
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <deque>
+#include <queue>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "Adafruit_CircuitPlayground.h"
+#include "EEPROM.h"
+
+void setup();
+void loop();
+
+SimSerial Serial;
+SimCircuitPlayground CircuitPlayground;
+SimEEPROM EEPROM;
+
+const uint64_t buttonHoldUs = 50000;  // how long a scripted press keeps the button down
+const uint64_t minStepUs = 50;        // progress guaranteed for a busy loop() pass
+
+enum EventKind { EVENT_LEFT, EVENT_RIGHT, EVENT_SWITCH, EVENT_SERIAL };
+
+struct Event {
+    uint64_t time;
+    uint64_t order;  // ties are resolved in the order events were scheduled
+    EventKind kind;
+    std::string text;
+    bool operator<(const Event &o) const {
+        return time != o.time ? time > o.time : order > o.order;
+    }
+};
+
+uint64_t nowUs = 0;
+uint64_t eventOrder = 0;
+std::priority_queue<Event> events;
+
+uint64_t leftUntil = 0, rightUntil = 0;
+bool switchOn = false;
+std::deque<uint8_t> serialInput;
+
+bool rawOutput = false, quiet = false;
+std::string outputLine;
+uint64_t serialBytes = 0, tones = 0;
+
+uint64_t lastMotionRead = 0;
+
+void schedule(uint64_t time, EventKind kind, const std::string &text = std::string()) {
+    events.push(Event{time, eventOrder++, kind, text});
+}
+
+/*
+accelerometer source: either a recorded/generated trace streamed from a
+file (zero-order hold, like the sensor's output register) or a
+synthetic sine tremor.
+*/
+class MotionSource {
+public:
+    FILE *trace = NULL;
+    double tremorHz = 4.5, tremorAmp = 2.0;
+
+    SimSample current = {0, 0, 9.81};
+    bool haveNext = false;
+    uint64_t nextTime = 0;
+    SimSample next = {0, 0, 9.81};
+
+    bool open(const char *path) {
+        trace = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+        if (trace == NULL) return false;
+        readNext();
+        return true;
+    }
+
+    // the trace is over once the last sample has been reached
+    bool exhausted() const { return trace != NULL && !haveNext; }
+
+    SimSample at(uint64_t t) {
+        if (trace == NULL) {
+            double s = t / 1e6;
+            return SimSample{0, 0, 9.81 + tremorAmp * sin(2 * M_PI * tremorHz * s)};
+        }
+        while (haveNext && nextTime <= t) {
+            current = next;
+            readNext();
+        }
+        return current;
+    }
+
+private:
+    void readNext() {
+        char line[256];
+        haveNext = false;
+        while (fgets(line, sizeof(line), trace)) {
+            if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+            if (line[0] == '@') {
+                parseEvent(line + 1);
+                continue;
+            }
+            unsigned long long t;
+            double x, y, z;
+            if (sscanf(line, "%llu,%lf,%lf,%lf", &t, &x, &y, &z) == 4) {
+                nextTime = t;
+                next = SimSample{x, y, z};
+                haveNext = true;
+                return;
+            }
+        }
+    }
+
+    void parseEvent(char *line) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char *comma = strchr(line, ',');
+        if (comma == NULL) return;
+        *comma = '\0';
+        uint64_t t = strtoull(line, NULL, 10);
+        char *what = comma + 1;
+        char *arg = strchr(what, ',');
+        if (arg) *arg++ = '\0';
+        if (strcmp(what, "left") == 0) schedule(t, EVENT_LEFT);
+        else if (strcmp(what, "right") == 0) schedule(t, EVENT_RIGHT);
+        else if (strcmp(what, "switch") == 0) schedule(t, EVENT_SWITCH, arg ? arg : "0");
+        else if (strcmp(what, "serial") == 0 && arg) schedule(t, EVENT_SERIAL, arg);
+    }
+};
+
+MotionSource motion;
+
+uint64_t simNow() {
+    return nowUs;
+}
+
+void simAdvance(uint64_t us) {
+    nowUs += us;
+}
+
+SimSample simMotion() {
+    lastMotionRead = nowUs;
+    return motion.at(nowUs);
+}
+
+bool simLeftPressed() { return nowUs < leftUntil; }
+bool simRightPressed() { return nowUs < rightUntil; }
+bool simSlideSwitch() { return switchOn; }
+
+int simSerialAvailable() {
+    return serialInput.size();
+}
+
+int simSerialRead() {
+    if (serialInput.empty()) return -1;
+    uint8_t c = serialInput.front();
+    serialInput.pop_front();
+    return c;
+}
+
+// text output is stamped with the virtual time it was printed at
+void simSerialWrite(const uint8_t *data, size_t length) {
+    serialBytes += length;
+    if (quiet) return;
+    if (rawOutput) {
+        fwrite(data, 1, length, stdout);
+        return;
+    }
+    for (size_t i = 0; i < length; i++) {
+        char c = data[i];
+        if (c == '\r') continue;
+        if (c != '\n') {
+            outputLine += (c >= 32 && c < 127) ? c : '.';
+            continue;
+        }
+        uint64_t ms = nowUs / 1000;
+        printf("[%02llu:%02llu:%02llu.%03llu] %s\n", (unsigned long long)(ms / 3600000),
+               (unsigned long long)(ms / 60000 % 60), (unsigned long long)(ms / 1000 % 60),
+               (unsigned long long)(ms % 1000), outputLine.c_str());
+        outputLine.clear();
+    }
+}
+
+void simTone(uint16_t freq, uint16_t) {
+    if (freq) tones++;
+}
+
+void simPixel(uint8_t, uint8_t, uint8_t, uint8_t) {}
+void simClearPixels() {}
+
+size_t SimSerial::print(long n, int base) {
+    if (n < 0) return print('-') + print((unsigned long)-n, base);
+    return print((unsigned long)n, base);
+}
+
+size_t SimSerial::print(unsigned long n, int base) {
+    char buf[8 * sizeof(long) + 1];
+    char *p = buf + sizeof(buf) - 1;
+    *p = '\0';
+    do {
+        unsigned digit = n % base;
+        *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        n /= base;
+    } while (n);
+    return print(p);
+}
+
+// same rounding and "nan"/"inf"/"ovf" spellings as the AVR core
+size_t SimSerial::print(double d, int digits) {
+    if (isnan(d)) return print("nan");
+    if (isinf(d)) return print("inf");
+    if (d > 4294967040.0 || d < -4294967040.0) return print("ovf");
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", digits, d);
+    return print(buf);
+}
+
+static void deliver(const Event &e) {
+    switch (e.kind) {
+    case EVENT_LEFT: leftUntil = e.time + buttonHoldUs; break;
+    case EVENT_RIGHT: rightUntil = e.time + buttonHoldUs; break;
+    case EVENT_SWITCH: switchOn = e.text != "0"; break;
+    case EVENT_SERIAL:
+        for (char c : e.text) serialInput.push_back(c);
+        serialInput.push_back('\n');
+        break;
+    }
+}
+
+/*
+after a loop() pass, move the clock to the earliest moment anything the
+sketch can observe changes: a scheduled event, a button release, the
+next trace sample or the next sample period. while the sketch is not
+sampling (device stopped) it is polled once per period, and pending
+serial input only gets minStepUs so each byte is seen promptly.
+*/
+static void idleJump(uint64_t samplePeriodUs) {
+    uint64_t due = lastMotionRead + samplePeriodUs;
+    uint64_t target = due > nowUs ? due : nowUs + samplePeriodUs;
+    if (!events.empty()) target = min(target, events.top().time);
+    if (leftUntil > nowUs) target = min(target, leftUntil);
+    if (rightUntil > nowUs) target = min(target, rightUntil);
+    if (motion.haveNext && motion.nextTime > nowUs) target = min(target, motion.nextTime);
+    if (!serialInput.empty() || target <= nowUs) target = nowUs + minStepUs;
+    nowUs = target;
+}
+
+static void loadEeprom(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return;
+    size_t n = fread(EEPROM.cells, 1, SimEEPROM::size, f);
+    (void)n;
+    fclose(f);
+}
+
+static void saveEeprom(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) return;
+    fwrite(EEPROM.cells, 1, SimEEPROM::size, f);
+    fclose(f);
+}
+
+int main(int argc, char **argv) {
+    double durationS = -1, pressLeftS = 0.5;
+    uint64_t samplePeriodUs = 20000;
+    const char *tracePath = NULL, *eepromPath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (strcmp(a, "--duration") == 0 && i + 1 < argc) durationS = atof(argv[++i]);
+        else if (strcmp(a, "--tremor") == 0 && i + 2 < argc) {
+            motion.tremorHz = atof(argv[++i]);
+            motion.tremorAmp = atof(argv[++i]);
+        } else if (strcmp(a, "--period") == 0 && i + 1 < argc) samplePeriodUs = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(a, "--press-left") == 0 && i + 1 < argc) pressLeftS = atof(argv[++i]);
+        else if (strcmp(a, "--serial") == 0 && i + 2 < argc) {
+            uint64_t t = atof(argv[i + 1]) * 1e6;
+            schedule(t, EVENT_SERIAL, argv[i + 2]);
+            i += 2;
+        } else if (strcmp(a, "--eeprom") == 0 && i + 1 < argc) eepromPath = argv[++i];
+        else if (strcmp(a, "--raw") == 0) rawOutput = true;
+        else if (strcmp(a, "--quiet") == 0) quiet = true;
+        else if (a[0] != '-' || strcmp(a, "-") == 0) tracePath = a;
+        else {
+            fprintf(stderr, "unknown option %s (see lib/ArduinoSim/sim.cpp)\n", a);
+            return 2;
+        }
+    }
+    if (tracePath && !motion.open(tracePath)) {
+        perror(tracePath);
+        return 1;
+    }
+    if (tracePath == NULL && durationS < 0) durationS = 600;
+    if (pressLeftS >= 0) schedule(pressLeftS * 1e6, EVENT_LEFT);
+    if (eepromPath) loadEeprom(eepromPath);
+
+    uint64_t endUs = durationS < 0 ? UINT64_MAX : (uint64_t)(durationS * 1e6);
+    uint64_t passes = 0;
+    setup();
+    while (nowUs < endUs && !motion.exhausted()) {
+        motion.at(nowUs);  // keeps trace events flowing while the device is stopped
+        while (!events.empty() && events.top().time <= nowUs) {
+            deliver(events.top());
+            events.pop();
+        }
+        loop();
+        passes++;
+        idleJump(samplePeriodUs);
+    }
+
+    if (eepromPath) saveEeprom(eepromPath);
+    fflush(stdout);
+    fprintf(stderr, "simulated %.3f s in %llu loop passes, %llu serial bytes, %llu tones, %u EEPROM writes\n",
+            nowUs / 1e6, (unsigned long long)passes, (unsigned long long)serialBytes,
+            (unsigned long long)tones, EEPROM.writes);
+    return 0;
+}
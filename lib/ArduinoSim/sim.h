@@ -0,0 +1,42 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <string>
+
+/*
+host simulator core. the sketch runs unmodified against a virtual clock
+that only moves when the simulator moves it: blocking calls (delay,
+playTone) advance it by their duration, and between loop() passes it
+jumps straight to the next thing that can change the sketch's behavior
+(the next accelerometer sample, button press or serial input). a day of
+wear therefore replays in seconds, and the same inputs always produce
+the same output.
+*/
+
+// virtual time in microseconds since reset
+uint64_t simNow();
+void simAdvance(uint64_t us);
+
+// one accelerometer reading in m/s^2
+struct SimSample {
+    double x, y, z;
+};
+
+// accelerometer as seen by the sketch at the current virtual time
+SimSample simMotion();
+
+bool simLeftPressed();
+bool simRightPressed();
+bool simSlideSwitch();
+
+// serial input queued for the sketch, serial output from it
+int simSerialAvailable();
+int simSerialRead();
+void simSerialWrite(const uint8_t *data, size_t length);
+
+void simTone(uint16_t freq, uint16_t ms);
+void simPixel(uint8_t n, uint8_t r, uint8_t g, uint8_t b);
+void simClearPixels();
+
+#endif
@@ -0,0 +1,119 @@
+"""
+Pre-build generator for include/dsp_tables.h.
+
+Writes a quarter wave of cos(2*pi*i/POINTS) in every numeric format the
+DSP path runs in (float, double, Q15, Q31). TremorDsp takes both its
+FFT twiddles and its Hamming window from these tables, so no trig runs
+on the device. The header is only rewritten when its content changes,
+and is committed so the host tools build without this step; run
+`python scripts/gen_tables.py` after changing POINTS.
+"""
+import math
+import os
+
+try:
+    Import("env")
+    ROOT = env.subst("$PROJECT_DIR")
+except NameError:  # run by hand
+    ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+POINTS = 128  # one full turn, the largest frame TremorDsp supports
+OUTPUT = os.path.join(ROOT, "include", "dsp_tables.h")
+
+
+def q(value, bits):
+    return min(int(math.floor(value * (1 << bits) + 0.5)), (1 << bits) - 1)
+
+
+def literal(value, digits):
+    text = "%.*g" % (digits, value)
+    return text if "." in text or "e" in text else text + ".0"
+
+
+def rows(values, per_row):
+    lines = []
+    for i in range(0, len(values), per_row):
+        lines.append("    " + ", ".join(values[i:i + per_row]) + ",")
+    return "\n".join(lines)
+
+
+def generate():
+    # the last entry is cos(pi / 2), exactly 0 rather than 6e-17
+    quarter = [math.cos(2 * math.pi * i / POINTS) for i in range(POINTS // 4)] + [0.0]
+    count = len(quarter)
+    text = """// generated by scripts/gen_tables.py, do not edit
+#ifndef DSP_TABLES_H
+#define DSP_TABLES_H
+
+#include <stdint.h>
+#if defined(__AVR__) || defined(ARDUINO_ARCH_SAMD)
+#include <avr/pgmspace.h>
+#else
+// host builds: tables are ordinary constants (same spelling as lib/ArduinoSim)
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_word
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#endif
+#ifndef pgm_read_dword
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#endif
+#ifndef pgm_read_float
+#define pgm_read_float(p) (*(const float *)(p))
+#endif
+#endif
+
+// cos(2 * pi * i / dspTablePoints) for the first quarter turn, i = 0 .. dspTablePoints / 4
+const uint16_t dspTablePoints = %(points)d;
+
+const float dspCosFloat[%(count)d] PROGMEM = {
+%(float)s
+};
+
+const double dspCosDouble[%(count)d] PROGMEM = {
+%(double)s
+};
+
+const int16_t dspCosQ15[%(count)d] PROGMEM = {
+%(q15)s
+};
+
+const int32_t dspCosQ31[%(count)d] PROGMEM = {
+%(q31)s
+};
+
+// double is a 4 byte float on AVR, where flash must be read explicitly
+inline double dspReadDouble(const double *p) {
+#ifdef __AVR__
+    return pgm_read_float(p);
+#else
+    return *p;
+#endif
+}
+
+#endif
+""" % {
+        "points": POINTS,
+        "count": count,
+        "float": rows([literal(v, 9) + "f" for v in quarter], 6),
+        "double": rows([literal(v, 17) for v in quarter], 4),
+        "q15": rows(["%d" % q(v, 15) for v in quarter], 10),
+        "q31": rows(["%dL" % q(v, 31) for v in quarter], 6),
+    }
+    return text.replace("\n", "\r\n")
+
+
+def write_if_changed(path, text):
+    try:
+        with open(path, newline="") as f:
+            if f.read() == text:
+                return
+    except IOError:
+        pass
+    with open(path, "w", newline="") as f:
+        f.write(text)
+    print("Generated %s" % os.path.relpath(path, ROOT))
+
+
+write_if_changed(OUTPUT, generate())
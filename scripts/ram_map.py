@@ -0,0 +1,57 @@
+"""
+Post-build RAM map for the circuitplay_classic firmware.
+
+Lists every symbol living in SRAM (.data/.bss) sorted by size, together
+with the totals, and writes the same report next to firmware.elf as
+ram_map.txt so a change in RAM budget shows up in review.
+"""
+import os
+import subprocess
+
+Import("env")
+
+RAM_SIZE = 2560  # ATmega32u4
+TOP_SYMBOLS = 25
+
+
+def ram_symbols(nm, elf):
+    out = subprocess.check_output([nm, "--size-sort", "-S", "-C", elf],
+                                  universal_newlines=True)
+    symbols = []
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) != 4:
+            continue
+        addr, size, kind, name = parts
+        # AVR data space is mapped at 0x800000 in the ELF
+        if kind.lower() not in ("b", "d") or int(addr, 16) < 0x800000:
+            continue
+        symbols.append((int(size, 16), kind, name))
+    symbols.sort(reverse=True)
+    return symbols
+
+
+def ram_map(source, target, env):
+    elf = str(target[0])
+    nm = env.subst("$CC").replace("gcc", "nm")
+    symbols = ram_symbols(nm, elf)
+    total = sum(size for size, _, _ in symbols)
+
+    lines = ["RAM map (%s)" % os.path.basename(elf),
+             "%6s  %s  %s" % ("bytes", "sec", "symbol")]
+    for size, kind, name in symbols[:TOP_SYMBOLS]:
+        sec = ".bss" if kind.lower() == "b" else ".data"
+        lines.append("%6d  %-5s %s" % (size, sec, name))
+    if len(symbols) > TOP_SYMBOLS:
+        rest = sum(size for size, _, _ in symbols[TOP_SYMBOLS:])
+        lines.append("%6d  (%d more symbols)" % (rest, len(symbols) - TOP_SYMBOLS))
+    lines.append("%6d  static total, %d of %d bytes left for heap and stack"
+                 % (total, RAM_SIZE - total, RAM_SIZE))
+
+    report = "\n".join(lines)
+    print(report)
+    with open(os.path.join(os.path.dirname(elf), "ram_map.txt"), "w") as f:
+        f.write(report + "\n")
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", ram_map)
@@ -0,0 +1,89 @@
+#include <Adafruit_CircuitPlayground.h>
+#include "alarm.h"
+
+const AlarmNote testNotes[] PROGMEM = {{1500, 100}};
+const AlarmNote noticeNotes[] PROGMEM = {{1000, 500}};
+const AlarmNote warningNotes[] PROGMEM = {{1000, 200}, {0, 100}, {1500, 200}, {0, 300}};
+const AlarmNote urgentNotes[] PROGMEM = {{2000, 150}, {0, 50}, {1500, 150}, {0, 50}};
+const AlarmNote powerNotes[] PROGMEM = {{1000, 500}, {0, 200}, {2000, 500}};
+const AlarmNote toggleNotes[] PROGMEM = {{2000, 500}};
+
+const AlarmPattern alarmPatterns[ALARM_COUNT] PROGMEM = {
+    {testNotes, 1, 1, 0},
+    {noticeNotes, 1, 1, 1},
+    {warningNotes, 4, 3, 2},
+    {urgentNotes, 4, 10, 3},
+    {powerNotes, 3, 1, alarmClickPriority},
+    {toggleNotes, 1, 1, alarmClickPriority},
+};
+
+const uint8_t alarmNone = 0xFF;
+
+uint8_t alarmPattern = alarmNone;  // playing, or alarmNone
+AlarmPattern alarmCurrent;         // its descriptor, copied out of flash
+uint8_t alarmNote = 0, alarmPass = 0;
+uint32_t alarmNoteEnd = 0;  // millis() when the next note is due
+uint32_t snoozeStart = 0, snoozeLength = 0;
+
+void alarmStart(uint8_t pattern) {
+    if (pattern >= ALARM_COUNT) return;
+    AlarmPattern p;
+    memcpy_P(&p, &alarmPatterns[pattern], sizeof(p));
+    if (p.priority < alarmClickPriority && alarmSnoozed()) return;
+    if (alarmPattern != alarmNone && p.priority <= alarmCurrent.priority) return;
+    alarmPattern = pattern;
+    alarmCurrent = p;
+    alarmNote = 0;
+    alarmPass = 0;
+    alarmNoteEnd = millis();
+}
+
+// cut the note the tone timer is playing instead of letting it run out
+void alarmStop() {
+    if (alarmPattern != alarmNone) noTone(CPLAY_BUZZER);
+    alarmPattern = alarmNone;
+}
+
+void alarmSnooze(uint32_t ms) {
+    snoozeStart = millis();
+    snoozeLength = ms;
+    if (ms > 0) alarmStop();
+}
+
+bool alarmPlaying() {
+    return alarmPattern != alarmNone;
+}
+
+bool alarmSnoozed() {
+    if (snoozeLength == 0) return false;
+    if (millis() - snoozeStart < snoozeLength) return true;
+    snoozeLength = 0;
+    return false;
+}
+
+void alarmPoll() {
+    if (alarmPattern == alarmNone) return;
+    uint32_t now = millis();
+    if ((int32_t)(now - alarmNoteEnd) < 0) return;
+    if (alarmNote >= alarmCurrent.count) {
+        alarmNote = 0;
+        if (++alarmPass >= alarmCurrent.repeats) {
+            alarmStop();
+            return;
+        }
+    }
+    AlarmNote n;
+    memcpy_P(&n, &alarmCurrent.notes[alarmNote], sizeof(n));
+    if (n.freq) CircuitPlayground.playTone(n.freq, n.ms, false);
+    else noTone(CPLAY_BUZZER);  // a rest is silent even if the last note has not run out
+    alarmNoteEnd = now + n.ms;
+    alarmNote++;
+}
+
+void alarmReport() {
+    Serial.print(F("Alarm Pattern: "));
+    if (alarmPlaying()) Serial.println(alarmPattern);
+    else Serial.println(F("none"));
+    Serial.print(F("Alarm Snooze: "));
+    Serial.println(alarmSnoozed() ? (snoozeLength - (millis() - snoozeStart)) / 1000 : 0);
+}
@@ -0,0 +1,118 @@
+#include <Arduino.h>
+#ifdef ARDUINO_ARCH_SAMD
+#include <FlashStorage_SAMD.h>  // the SAMD21 has no EEPROM, this emulates it in flash
+#else
+#include <EEPROM.h>
+#endif
+#include <stddef.h>
+#include "calibration.h"
+
+const uint8_t recordMagic = 0xCA;
+const uint8_t recordVersion = 2;  // bump whenever TuningParams changes layout
+
+struct CalibrationRecord {
+    uint8_t magic;
+    uint8_t version;
+    uint16_t sequence;
+    TuningParams params;
+    uint16_t crc;  // over every byte before it
+};
+
+const uint16_t slotSize = sizeof(CalibrationRecord);
+int8_t currentSlot = -1;
+uint16_t currentSequence = 0;
+
+static uint16_t slotAddress(uint8_t slot) {
+    return calibrationBase + slot * slotSize;
+}
+
+// CRC-16/CCITT, bitwise to keep flash use small
+static uint16_t crc16(const uint8_t *data, uint16_t length) {
+    uint16_t crc = 0xFFFF;
+    while (length--) {
+        crc ^= (uint16_t)*data++ << 8;
+        for (uint8_t i = 0; i < 8; i++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+static uint16_t recordCrc(const CalibrationRecord &r) {
+    return crc16((const uint8_t *)&r, offsetof(CalibrationRecord, crc));
+}
+
+// sequence numbers wrap, so compare them as a signed distance
+static bool newer(uint16_t a, uint16_t b) {
+    return (int16_t)(a - b) > 0;
+}
+
+/*
+only the 4 byte headers are read while looking for the newest slot,
+the full record and its CRC are checked for that one candidate. a bad
+CRC (e.g. power lost mid-save) falls back to the next newest slot, so
+boot costs a few hundred EEPROM byte reads at worst.
+*/
+bool calibrationLoad(TuningParams &p) {
+    bool tried[calibrationSlots] = {false};
+    for (uint8_t attempt = 0; attempt < calibrationSlots; attempt++) {
+        int8_t best = -1;
+        uint16_t bestSequence = 0;
+        for (uint8_t slot = 0; slot < calibrationSlots; slot++) {
+            if (tried[slot]) continue;
+            uint16_t addr = slotAddress(slot);
+            if (EEPROM.read(addr) != recordMagic || EEPROM.read(addr + 1) != recordVersion) continue;
+            uint16_t sequence = EEPROM.read(addr + 2) | (EEPROM.read(addr + 3) << 8);
+            if (best < 0 || newer(sequence, bestSequence)) {
+                best = slot;
+                bestSequence = sequence;
+            }
+        }
+        if (best < 0) return false;
+
+        CalibrationRecord r;
+        EEPROM.get(slotAddress(best), r);
+        if (r.crc == recordCrc(r) && paramsValid(r.params)) {
+            p = r.params;
+            currentSlot = best;
+            currentSequence = r.sequence;
+            return true;
+        }
+        tried[best] = true;
+    }
+    return false;
+}
+
+/*
+the new record goes to the slot after the current one. EEPROM.put()
+only rewrites bytes that changed, and the previous profile stays
+intact until the new one is complete.
+*/
+bool calibrationSave(const TuningParams &p) {
+    if (!paramsValid(p)) return false;
+    CalibrationRecord r;
+    r.magic = recordMagic;
+    r.version = recordVersion;
+    r.sequence = currentSlot < 0 ? 0 : currentSequence + 1;
+    r.params = p;
+    r.crc = recordCrc(r);
+
+    uint8_t slot = currentSlot < 0 ? 0 : (currentSlot + 1) % calibrationSlots;
+    EEPROM.put(slotAddress(slot), r);
+#ifdef ARDUINO_ARCH_SAMD
+    EEPROM.commit();
+#endif
+
+    CalibrationRecord check;
+    EEPROM.get(slotAddress(slot), check);
+    if (memcmp(&check, &r, sizeof(r)) != 0) return false;
+    currentSlot = slot;
+    currentSequence = r.sequence;
+    return true;
+}
+
+int8_t calibrationSlot() {
+    return currentSlot;
+}
+
+uint16_t calibrationEnd() {
+    return slotAddress(calibrationSlots);
+}
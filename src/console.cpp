@@ -0,0 +1,198 @@
+#include <Arduino.h>
+#include <stddef.h>
+#include "console.h"
+#include "params.h"
+#include "calibration.h"
+#include "memstats.h"
+#include "profiler.h"
+#include "spectro.h"
+#include "scheduler.h"
+#include "timing.h"
+#include "alarm.h"
+#include "history.h"
+#include "rollup.h"
+
+const uint8_t lineSize = 32;
+const uint8_t maxBytesPerPoll = 16;  // bounds the time spent here per loop() pass
+char line[lineSize];
+uint8_t lineLength = 0;
+bool lineOverflow = false;
+
+enum FieldKind { FIELD_DOUBLE, FIELD_ULONG, FIELD_BYTE };
+
+// kept in flash whole, names included; findField() copies one entry out
+struct ParamField {
+    char name[20];
+    uint8_t kind;
+    uint8_t offset;
+};
+
+const ParamField paramFields[] PROGMEM = {
+    {"dangerZoneIntensity", FIELD_DOUBLE, offsetof(TuningParams, dangerZoneIntensity)},
+    {"dangerRatio", FIELD_DOUBLE, offsetof(TuningParams, dangerRatio)},
+    {"sampleInterval", FIELD_ULONG, offsetof(TuningParams, sampleInterval)},
+    {"evaluationPeriod", FIELD_ULONG, offsetof(TuningParams, evaluationPeriod)},
+    {"lowThreshold", FIELD_DOUBLE, offsetof(TuningParams, lowThreshold)},
+    {"highThreshold", FIELD_DOUBLE, offsetof(TuningParams, highThreshold)},
+    {"bandLowHz", FIELD_DOUBLE, offsetof(TuningParams, bandLowHz)},
+    {"bandHighHz", FIELD_DOUBLE, offsetof(TuningParams, bandHighHz)},
+    {"welchSegments", FIELD_BYTE, offsetof(TuningParams, welchSegments)},
+};
+const uint8_t paramFieldCount = sizeof(paramFields) / sizeof(paramFields[0]);
+
+static void printField(const ParamField &f, const TuningParams &p) {
+    const char *base = (const char *)&p;
+    Serial.print(f.name); Serial.print(F(": "));
+    if (f.kind == FIELD_DOUBLE) Serial.println(*(const double *)(base + f.offset));
+    else if (f.kind == FIELD_ULONG) Serial.println(*(const unsigned long *)(base + f.offset));
+    else Serial.println(*(const uint8_t *)(base + f.offset));
+}
+
+static bool findField(const char *name, ParamField &f) {
+    for (uint8_t i = 0; i < paramFieldCount; i++) {
+        if (strcmp_P(name, paramFields[i].name) == 0) {
+            memcpy_P(&f, &paramFields[i], sizeof(f));
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+edits always start from the pending set, so several `set` commands
+typed between two frames are installed together.
+*/
+static void setField(const char *name, const char *value) {
+    ParamField f;
+    if (!findField(name, f) || value == NULL) {
+        Serial.println(F("error: usage set <name> <value>"));
+        return;
+    }
+    char *end;
+    TuningParams p = paramsPending();
+    char *base = (char *)&p;
+    unsigned long number = 0;
+    if (f.kind == FIELD_DOUBLE) *(double *)(base + f.offset) = strtod(value, &end);
+    else number = strtoul(value, &end, 10);
+    if (f.kind == FIELD_ULONG) *(unsigned long *)(base + f.offset) = number;
+    else if (f.kind == FIELD_BYTE) *(uint8_t *)(base + f.offset) = number > 255 ? 0 : number;
+    if (end == value || *end != '\0') {
+        Serial.println(F("error: bad number"));
+    } else if (!paramsStage(p)) {
+        Serial.println(F("error: rejected, parameters would be inconsistent"));
+    } else {
+        Serial.println(F("ok: applied at next frame"));
+    }
+}
+
+static void runCommand(char *cmd) {
+    char *verb = strtok(cmd, " ");
+    if (verb == NULL) return;
+    char *arg1 = strtok(NULL, " ");
+    char *arg2 = strtok(NULL, " ");
+
+    if (strcmp_P(verb, PSTR("get")) == 0) {
+        for (uint8_t i = 0; i < paramFieldCount; i++) {
+            ParamField f;
+            memcpy_P(&f, &paramFields[i], sizeof(f));
+            printField(f, params);
+        }
+    } else if (strcmp_P(verb, PSTR("set")) == 0 && arg1 != NULL) {
+        setField(arg1, arg2);
+    } else if (strcmp_P(verb, PSTR("defaults")) == 0) {
+        paramsStage(defaultParams);
+        Serial.println(F("ok: applied at next frame"));
+    } else if (strcmp_P(verb, PSTR("save")) == 0) {
+        Serial.println(calibrationSave(paramsPending()) ? F("ok: profile saved") : F("error: save failed"));
+    } else if (strcmp_P(verb, PSTR("load")) == 0) {
+        TuningParams p;
+        if (calibrationLoad(p) && paramsStage(p)) Serial.println(F("ok: applied at next frame"));
+        else Serial.println(F("error: no stored profile"));
+    } else if (strcmp_P(verb, PSTR("stream")) == 0) {
+        if (arg1 != NULL && strcmp_P(arg1, PSTR("on")) == 0) {
+            spectroStreaming = true;
+            Serial.println(F("ok: spectrogram on"));
+        } else if (arg1 != NULL && strcmp_P(arg1, PSTR("off")) == 0) {
+            spectroStreaming = false;
+            Serial.println(F("ok: spectrogram off"));
+        } else {
+            Serial.println(F("error: usage stream on|off"));
+        }
+    } else if (strcmp_P(verb, PSTR("sched")) == 0) {
+        if (arg1 != NULL && strcmp_P(arg1, PSTR("reset")) == 0) schedulerReset();
+        else schedulerReport();
+    } else if (strcmp_P(verb, PSTR("timing")) == 0) {
+        if (arg1 != NULL && strcmp_P(arg1, PSTR("reset")) == 0) timingReset();
+        else timingReport();
+    } else if (strcmp_P(verb, PSTR("alarm")) == 0) {
+        if (arg1 == NULL) {
+            alarmReport();
+        } else if (strcmp_P(arg1, PSTR("snooze")) == 0) {
+            unsigned long minutes = arg2 != NULL ? strtoul(arg2, NULL, 10) : 10;
+            alarmSnooze(minutes * 60000UL);
+            Serial.println(minutes ? F("ok: alarm snoozed") : F("ok: snooze over"));
+        } else if (strcmp_P(arg1, PSTR("stop")) == 0) {
+            alarmStop();
+            Serial.println(F("ok: alarm stopped"));
+        } else if (strcmp_P(arg1, PSTR("test")) == 0) {
+            alarmStart(ALARM_TEST);
+        } else {
+            Serial.println(F("error: usage alarm [snooze [minutes]|stop|test]"));
+        }
+    } else if (strcmp_P(verb, PSTR("history")) == 0) {
+        if (arg1 != NULL && strcmp_P(arg1, PSTR("clear")) == 0) {
+            historyClear();
+            Serial.println(F("ok: history cleared"));
+        } else {
+            historyDump();
+        }
+    } else if (strcmp_P(verb, PSTR("trend")) == 0) {
+        RollupEntry e;
+        if (arg1 != NULL && strcmp_P(arg1, PSTR("days")) == 0) {
+            rollupToday(e);
+            rollupPrint(F("Today"), e);
+            for (uint8_t back = 1; rollupDay(back, e); back++) {
+                Serial.print(F("Day -")); Serial.println(back);
+                rollupPrint(F("Day"), e);
+            }
+        } else {
+            uint32_t covered = rollupQuery(arg1 != NULL ? strtoul(arg1, NULL, 10) : 60, e);
+            Serial.print(F("Trend Minutes: ")); Serial.println(covered);
+            rollupPrint(F("Trend"), e);
+        }
+    } else if (strcmp_P(verb, PSTR("mem")) == 0) {
+        memstatsScan();
+        memstatsReport();
+#ifdef ENABLE_PROFILER
+    } else if (strcmp_P(verb, PSTR("prof")) == 0) {
+        if (arg1 != NULL && strcmp_P(arg1, PSTR("reset")) == 0) profilerReset();
+        else profilerDump();
+#endif
+    } else {
+        Serial.println(F("error: unknown command"));
+    }
+}
+
+/*
+append whatever bytes are waiting to the line buffer and run the
+command when a line ends. an over-long line is dropped whole rather
+than executed truncated.
+*/
+void consolePoll() {
+    for (uint8_t n = 0; n < maxBytesPerPoll && Serial.available(); n++) {
+        char c = Serial.read();
+        if (c == '\r' || c == '\n') {
+            if (lineOverflow) Serial.println(F("error: line too long"));
+            else if (lineLength > 0) {
+                line[lineLength] = '\0';
+                runCommand(line);
+            }
+            lineLength = 0;
+            lineOverflow = false;
+        } else if (lineLength < lineSize - 1) {
+            line[lineLength++] = c;
+        } else {
+            lineOverflow = true;
+        }
+    }
+}
@@ -0,0 +1,11 @@
+#include "dcblocker.h"
+
+DcBlocker dcBlocker;
+
+void dcBlockerReset() {
+    dcBlocker.reset();
+}
+
+int32_t dcBlockerStep(int32_t sample) {
+    return dcBlocker.step(sample);
+}
@@ -0,0 +1,239 @@
+#include <Arduino.h>
+#ifdef ARDUINO_ARCH_SAMD
+#include <FlashStorage_SAMD.h>
+#else
+#include <EEPROM.h>
+#endif
+#include "history.h"
+#include "calibration.h"
+
+const uint8_t blockMagic = 0xB7;
+const uint8_t flagBoot = 0x01;  // first block written after a power up
+const uint8_t headerSize = 5;
+const uint8_t dataSize = historyBlockSize - headerSize;
+
+struct HistoryBlock {
+    uint8_t magic;
+    uint8_t flags;
+    uint16_t sequence;
+    uint8_t used;
+    uint8_t data[dataSize];
+};
+
+HistoryBlock block;        // the block being filled, mirrored to EEPROM on flush
+uint8_t blockSlot = 0;
+uint8_t blockCount = 0;    // ring slots that fit in the EEPROM
+int32_t lastMean = 0, lastPeak = 0;  // delta bases within the block
+bool blockDirty = false;
+uint16_t gapMinutes = 0;   // empty minutes not yet written as a gap entry
+uint8_t minutesSinceFlush = 0;
+bool flushing = false;     // block bytes still to compare with the EEPROM
+uint8_t flushCursor = 0;   // the next of them, in write order (see flushStep())
+bool blockClosing = false; // block is full; the next one starts once it is all written
+uint16_t heldFrames = 0, heldMean = 0, heldPeak = 0;  // the minute that did not fit, frames 0 if none
+
+static uint16_t blockAddress(uint8_t slot) {
+    return calibrationEnd() + slot * historyBlockSize;
+}
+
+static uint8_t putVarint(uint8_t *out, uint32_t v) {
+    uint8_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (v & 0x7F) | 0x80;
+        v >>= 7;
+    }
+    out[n++] = v;
+    return n;
+}
+
+static bool getVarint(const uint8_t *in, uint8_t length, uint8_t &pos, uint32_t &v) {
+    v = 0;
+    for (uint8_t shift = 0; pos < length && shift < 32; shift += 7) {
+        uint8_t b = in[pos++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static void newBlock(uint16_t sequence, uint8_t flags) {
+    block.magic = blockMagic;
+    block.flags = flags;
+    block.sequence = sequence;
+    block.used = 0;
+    lastMean = 0;
+    lastPeak = 0;
+    blockDirty = false;
+    flushing = false;
+    blockClosing = false;
+}
+
+void historyBegin() {
+    uint16_t room = EEPROM.length() - calibrationEnd();
+    blockCount = room / historyBlockSize;
+    int16_t newest = -1;
+    uint16_t newestSequence = 0;
+    for (uint8_t slot = 0; slot < blockCount; slot++) {
+        uint16_t addr = blockAddress(slot);
+        if (EEPROM.read(addr) != blockMagic) continue;
+        uint16_t sequence = EEPROM.read(addr + 2) | (EEPROM.read(addr + 3) << 8);
+        if (newest < 0 || (int16_t)(sequence - newestSequence) > 0) {
+            newest = slot;
+            newestSequence = sequence;
+        }
+    }
+    blockSlot = newest < 0 ? 0 : (newest + 1) % blockCount;
+    newBlock(newest < 0 ? 0 : newestSequence + 1, flagBoot);
+}
+
+void historyFlush() {
+    if (!blockDirty || blockCount == 0) return;
+    flushing = true;
+    flushCursor = 0;
+    minutesSinceFlush = 0;
+}
+
+/*
+writes the next block byte that differs from the EEPROM, if any, and
+returns false once there are none left. the used data bytes come first
+and the header (whose last byte is the used count) after them.
+*/
+static bool flushStep() {
+    const uint8_t *bytes = (const uint8_t *)&block;
+    uint16_t addr = blockAddress(blockSlot);
+    while (flushCursor < historyBlockSize) {
+        uint8_t i = (flushCursor++ + headerSize) % historyBlockSize;
+        if (i >= headerSize + block.used) continue;
+        if (EEPROM.read(addr + i) == bytes[i]) continue;
+        EEPROM.update(addr + i, bytes[i]);
+        return true;
+    }
+    return false;
+}
+
+static bool record(uint16_t frames, uint16_t mean, uint16_t peak);
+
+// the block is all in EEPROM; a full one makes way for the next
+static void flushDone() {
+#ifdef ARDUINO_ARCH_SAMD
+    EEPROM.commit();
+#endif
+    flushing = false;
+    blockDirty = false;
+    if (!blockClosing) return;
+    blockSlot = (blockSlot + 1) % blockCount;
+    newBlock(block.sequence + 1, 0);
+    if (heldFrames > 0) record(heldFrames, heldMean, heldPeak);
+    heldFrames = 0;
+}
+
+void historyPoll() {
+    if (flushing && !flushStep()) flushDone();
+}
+
+// one entry into the block; false if it does not fit, which closes the block
+static bool append(uint16_t frames, int32_t mean, int32_t peak) {
+    uint8_t entry[16];
+    uint8_t n = putVarint(entry, frames);
+    if (frames > 0) {
+        n += putVarint(entry + n, zigzag(mean - lastMean));
+        n += putVarint(entry + n, zigzag(peak - lastPeak));
+    } else {
+        n += putVarint(entry + n, gapMinutes);
+    }
+    if (block.used + n > dataSize) {
+        blockClosing = true;
+        flushing = true;
+        flushCursor = 0;
+        minutesSinceFlush = 0;
+        return false;
+    }
+    memcpy(block.data + block.used, entry, n);
+    block.used += n;
+    if (frames > 0) {
+        lastMean = mean;
+        lastPeak = peak;
+    }
+    blockDirty = true;
+    flushCursor = 0;  // a flush under way compares the block again from the start
+    return true;
+}
+
+// a minute with frames, after the gap entry for any empty minutes before it
+static bool record(uint16_t frames, uint16_t mean, uint16_t peak) {
+    if (gapMinutes > 0) {
+        if (!append(0, 0, 0)) return false;
+        gapMinutes = 0;
+    }
+    return append(frames, mean, peak);
+}
+
+void historyMinute(uint16_t frames, uint16_t mean, uint16_t peak) {
+    if (blockCount == 0) return;
+    if (blockClosing) {  // historyPoll() has not kept up for a whole minute: write the rest now
+        while (flushStep()) {}
+        flushDone();
+    }
+    if (frames == 0) {
+        gapMinutes++;
+    } else if (!record(frames, mean, peak)) {
+        heldFrames = frames;
+        heldMean = mean;
+        heldPeak = peak;
+    }
+    if (++minutesSinceFlush >= historyFlushMinutes) historyFlush();
+}
+
+// the entries of one stored block as "History: frames,mean,peak" or "History: gap N" lines
+static void dumpBlock(const HistoryBlock &b) {
+    if (b.flags & flagBoot) Serial.println(F("History: boot"));
+    int32_t mean = 0, peak = 0;
+    uint8_t used = b.used < dataSize ? b.used : dataSize;
+    for (uint8_t pos = 0; pos < used;) {
+        uint32_t frames, a, c;
+        if (!getVarint(b.data, used, pos, frames) || !getVarint(b.data, used, pos, a)) return;
+        if (frames == 0) {
+            Serial.print(F("History: gap ")); Serial.println(a);
+            continue;
+        }
+        if (!getVarint(b.data, used, pos, c)) return;
+        mean += unzigzag(a);
+        peak += unzigzag(c);
+        Serial.print(F("History: ")); Serial.print(frames);
+        Serial.print(F(",")); Serial.print(mean);
+        Serial.print(F(",")); Serial.println(peak);
+    }
+}
+
+/*
+the ring is walked from the slot after the current one, which is the
+oldest block once the ring has wrapped, and ends with the block in RAM
+(its slot may still hold the block it is about to replace). slots never
+written fail the magic check and are skipped.
+*/
+void historyDump() {
+    for (uint8_t i = 1; i < blockCount; i++) {
+        HistoryBlock b;
+        EEPROM.get(blockAddress((blockSlot + i) % blockCount), b);
+        if (b.magic == blockMagic) dumpBlock(b);
+    }
+    if (blockCount > 0) dumpBlock(block);
+}
+
+void historyClear() {
+    for (uint8_t slot = 0; slot < blockCount; slot++) EEPROM.update(blockAddress(slot), 0xFF);
+#ifdef ARDUINO_ARCH_SAMD
+    EEPROM.commit();
+#endif
+    blockSlot = 0;
+    heldFrames = 0;
+    newBlock(0, 0);
+}
@@ -1,45 +1,120 @@
 
-#include <ArduinoFFT.h>
 #include <Adafruit_CircuitPlayground.h>
+#include "dsp_backend.h"
+#include "memstats.h"
+#include "profiler.h"
+#include "params.h"
+#include "console.h"
+#include "calibration.h"
+#include "dcblocker.h"
+#include "spectro.h"
+#include "scheduler.h"
+#include "timing.h"
+#include "alarm.h"
+#include "feedback.h"
+#include "history.h"
+#include "rollup.h"
 
 // note: SerialPrint(s) added for visibility and clarity of performance
 
 // constants
-const uint16_t samples = 128;
 const double samplingFreq = 50.0;
-const double dangerZoneIntensity = 60.0;
-const int sampleInterval = 2000;  // interval for each sample set in milliseconds
-const int evaluationPeriod = 10 * 60 * 1000;  // total period for evaluation in milliseconds
-double vReal[samples], vImag[samples];
-unsigned int index = 0, sampleCount = 0, dangerCount = 0;
-unsigned long lastTime = 0, lastSampleSetTime = 0;
-unsigned long samplingPeriod = 1000000 / samplingFreq;
+const uint8_t sampleFracBits = 15;  // dcScale counts per dspFullScale: 1024 * 32 = 2^15
+const uint16_t fftSliceUs = 2000;  // FFT work per analyze slice before sampling gets a look in
+SketchDsp dsp;  // see dsp_backend.h
+unsigned int sampleIndex = 0, sampleCount = 0, dangerCount = 0;
+
+/*
+ping-pong acquisition frames: collectSamples() fills one with DC
+blocked samples in dcScale counts (int16 holds +-32 m/s^2, beyond the
++-16 m/s^2 the fixed point DSP types span) while the analyze task
+loads the other into the DSP, so sampling never waits on the FFT. the
+pair is 512 bytes, half of one more double frame.
+*/
+int16_t frames[2][samples];
+uint8_t fillFrame = 0;       // frame collectSamples() is writing
+bool frameReady = false;     // frames[fillFrame ^ 1] is complete and not yet loaded
+bool frameTimingOk[2];       // timingFrameEnd() verdict for each frame
+bool spectrumTimingOk = true;  // the same for the frame behind dsp's spectrum
+uint32_t lastSampleSetTime = 0;  // millis(); 32 bits like the device so the differences wrap
+const uint32_t samplingPeriod = 20000;  // us, 1 / samplingFreq; an integer constant so the task table can sit in flash
 bool isDeviceRunning = false;
 bool isAlarmEnabled = false;
+uint8_t alarmStreak = 0;  // consecutive evaluation periods that sounded the alarm
+double intensity = 0;  // latest analyzeFFT() result
+double dominantHz = 0;  // frequency of the band peak behind it
+FeedbackState feedback;  // Neopixel level shown for it
+
+// a button's debounced state; changes closer than buttonDebounceMs to the last one are contact bounce
+struct ButtonState {
+    bool down;
+    uint32_t changedMs;
+};
+const uint16_t buttonDebounceMs = 200;
+ButtonState leftButton = {false, 0}, rightButton = {false, 0};
 
 // function declarations
 void handleButtonPress();
-bool collectSamples();
-void performFFT();
+bool collectSamples(uint32_t gridUs, uint32_t takenUs);
+bool performFFT();
 double analyzeFFT();
-void updateFeedback(double intensity);
+void updateFeedback(uint8_t level);
+bool taskAcquire();
+bool taskSound();
+bool taskFeedback();
+bool taskTelemetry();
+bool taskEvaluate();
+bool taskAnalyze();
+bool taskUi();
+
+/*
+the sketch's work as scheduler tasks, highest priority first (see
+scheduler.h). sampling outranks everything; one frame's analysis then
+fans out to the LEDs, the serial output and the danger bookkeeping.
+deadlines are the release-to-start delays counted as misses.
+*/
+enum TaskId { TASK_ACQUIRE, TASK_SOUND, TASK_FEEDBACK, TASK_TELEMETRY, TASK_EVALUATE, TASK_ANALYZE, TASK_UI };
+const Task tasks[] PROGMEM = {
+    {"acquire", taskAcquire, samplingPeriod, 2000},  // one sample per period
+    {"sound", taskSound, 5000, 5000},  // alarm note changes
+    {"feedback", taskFeedback, 0, 20000},
+    {"telemetry", taskTelemetry, 0, 20000},
+    {"evaluate", taskEvaluate, 0, 20000},
+    {"analyze", taskAnalyze, 0, 20000},
+    {"ui", taskUi, 10000, 50000},  // buttons and serial commands
+};
+const uint8_t taskCount = sizeof(tasks) / sizeof(tasks[0]);
 
 /*
 set up baud rate to 115200 and initialize constraints for
-the Circuit Playground library...also set the imaginary
-part of the vector to 0.
+the Circuit Playground library.
 */
 void setup() {
     Serial.begin(115200);
     CircuitPlayground.begin();
     CircuitPlayground.clearPixels(); // clear Neopixels to start fresh
-    memset(vImag, 0, sizeof(vImag));
-    for (int i = 0; i < samples; i++) vImag[i] = 0;
     lastSampleSetTime = millis();
+    // this wearer's stored thresholds, if any, replace the defaults
+    if (calibrationLoad(params)) {
+        Serial.print(F("Calibration Slot: ")); Serial.println(calibrationSlot());
+    } else {
+        Serial.println(F("Calibration: defaults"));
+    }
+    historyBegin();
+    rollupBegin();
+    memstatsScan();
+    memstatsReport();  // boot-time RAM budget
+#ifdef ENABLE_PROFILER
+    profilerBegin();
+#endif
+    timingBegin(samplingPeriod);
+    schedulerBegin();
 }
 
 /*
-loop() handles counting of samples and "danger" analysis.
+loop() only runs the scheduler; the work itself is split into the
+tasks below.
+
 all incoming samples are said to be within 3-6 Hz frequency...if more
 than 60% of these samples are found to be above the current
 dangerZoneIntensity value, the alarm would sound. 
@@ -52,66 +127,163 @@ for an entire tremor), and whether its intensity is greater than the specified
 dangerZoneIntensity.
 */
 void loop() {
-    handleButtonPress();  // handle button interactions to start/stop device and toggle alarm (if required)
-    if (isDeviceRunning) {
-        if (collectSamples()) {  // collect data samples for the FFT
-            performFFT();  // perform FFT on the collected data
-            double intensity = analyzeFFT();  // analyze FFT data to calculate maximum intensity
-            updateFeedback(intensity);  // update Neopixels based on calculated intensity
-            // debug output to monitor intensity values
-            Serial.print("Intensity: "); Serial.println(intensity);
-
-            if (millis() - lastSampleSetTime >= sampleInterval) {
-                if (intensity >= dangerZoneIntensity) {
-                    dangerCount++;  // increment count of dangerous samples
-                }
-                sampleCount++;  // increment total count of samples
-
-                // debug outputs to check into counts of samples and dangerous occurrences
-                Serial.print("Sample Count: "); Serial.println(sampleCount);
-                Serial.print("Danger Count: "); Serial.println(dangerCount);
-
-                if (millis() - lastSampleSetTime >= evaluationPeriod) {  // check if evaluation period is over
-                    double dangerRatio = (double)dangerCount / sampleCount;
-                    Serial.print("Danger Ratio: "); Serial.println(dangerRatio);
-                    if (dangerRatio >= 0.6 && isAlarmEnabled) {
-                        Serial.println("Alarm sounding: Danger level exceeded");
-                        // potential additional code to trigger alarm
-                        CircuitPlayground.playTone(1000, 500);  // play a 1000 Hz tone for 500 milliseconds
-                    } else {
-                        Serial.println("Not enough danger signals to sound the alarm.");
-                    }
-                    // reset counters following evaluation period
-                    dangerCount = 0;
-                    sampleCount = 0;
-                    lastSampleSetTime = millis();
-                }
+    schedulerRun();
+}
+
+/*
+one accelerometer sample per release. the scheduler releases on an
+absolute grid of samplingPeriod, so the release time is the instant the
+sample stands for; it is compared with the time of the reading for the
+timing monitor and for resampling. a full frame is handed over by flipping the
+ping-pong pair; if the previous one was never picked up the analysis
+is running behind, and the newer frame replaces it.
+*/
+bool taskAcquire() {
+    if (!isDeviceRunning) {
+        // a partly filled frame would straddle the stop; the next start begins a fresh one
+        sampleIndex = 0;
+        timingRestart();
+        return false;
+    }
+    uint32_t grid = schedulerReleaseTime(TASK_ACQUIRE);
+    uint32_t taken = micros();
+    timingSample(grid, taken);
+    if (collectSamples(grid, taken)) {  // a full frame is ready
+        frameTimingOk[fillFrame] = timingFrameEnd();
+        if (frameReady) timingOverrun();
+        fillFrame ^= 1;
+        frameReady = true;
+        schedulerRelease(TASK_ANALYZE);
+    }
+    return false;
+}
+
+/*
+the FFT is spread over as many slices as it needs (see performFFT()),
+so the longest analyze slice in `sched` stays near fftSliceUs whatever
+the frame size.
+*/
+bool taskAnalyze() {
+    if (!dsp.busy()) {
+        if (!frameReady) return false;
+        paramsApplyPending();  // parameter changes only take effect between frames
+        const int16_t *frame = frames[fillFrame ^ 1];
+        for (uint16_t i = 0; i < samples; i++) dsp.setSample(i, frame[i], sampleFracBits);
+        spectrumTimingOk = frameTimingOk[fillFrame ^ 1];
+        frameReady = false;
+        dsp.begin(params.welchSegments);
+    }
+    if (!performFFT()) return true;  // more of the transform to do on the next slice
+    intensity = analyzeFFT();  // analyze FFT data to calculate maximum intensity
+    schedulerRelease(TASK_FEEDBACK);
+    schedulerRelease(TASK_TELEMETRY);
+    schedulerRelease(TASK_EVALUATE);
+    return frameReady;  // the next frame filled up meanwhile; its release was absorbed by this one
+}
+
+bool taskSound() {
+    alarmPoll();
+    return false;
+}
+
+// the pixels are only rewritten when the hysteresis moves the level (see feedback.h)
+bool taskFeedback() {
+    if (feedbackUpdate(feedback, intensity, params.lowThreshold, params.highThreshold)) {
+        updateFeedback(feedback.shown);  // update Neopixels based on calculated intensity
+    }
+    return false;
+}
+
+bool taskTelemetry() {
+    if (spectroStreaming) {  // compact spectrogram row for the host
+        uint8_t bins[spectroBins];
+        for (uint8_t i = 0; i < spectroBins; i++) {
+            bins[i] = spectroQuantize(dsp.magnitude(spectroSourceBin(i, dsp.fftSize)));
+        }
+        spectroSend(bins);
+    }
+    // debug output to monitor intensity values
+    Serial.print(F("Intensity: ")); Serial.println(intensity);
+    Serial.print(F("Sample Rate: ")); Serial.println(timingSampleRate());
+    if (!spectrumTimingOk) Serial.println(F("Frame Timing: suspect"));
+    return false;
+}
+
+/*
+danger counting once per sampleInterval, alarm decision once per
+evaluationPeriod. frames with suspect timing are left out; the next
+trustworthy frame takes their place.
+*/
+bool taskEvaluate() {
+    if (!spectrumTimingOk) return false;
+    rollupFrame(intensity, dominantHz, intensity >= params.dangerZoneIntensity);
+    if (millis() - lastSampleSetTime >= params.sampleInterval) {
+        if (intensity >= params.dangerZoneIntensity) {
+            dangerCount++;  // increment count of dangerous samples
+        }
+        sampleCount++;  // increment total count of samples
+
+        // debug outputs to check into counts of samples and dangerous occurrences
+        Serial.print(F("Sample Count: ")); Serial.println(sampleCount);
+        Serial.print(F("Danger Count: ")); Serial.println(dangerCount);
+
+        // stack high-water mark after a full collect/FFT/feedback pass
+        memstatsScan();
+        Serial.print(F("Stack Min Free: ")); Serial.println(memstatsMinFree());
+
+        if (millis() - lastSampleSetTime >= params.evaluationPeriod) {  // check if evaluation period is over
+            double dangerRatio = (double)dangerCount / sampleCount;
+            Serial.print(F("Danger Ratio: ")); Serial.println(dangerRatio);
+            if (dangerRatio >= params.dangerRatio && isAlarmEnabled) {
+                Serial.println(F("Alarm sounding: Danger level exceeded"));
+                // the pattern escalates while period after period keeps alarming
+                if (alarmStreak <= ALARM_URGENT - ALARM_NOTICE) alarmStreak++;
+                alarmStart(ALARM_NOTICE + alarmStreak - 1);
+                if (alarmSnoozed()) Serial.println(F("Alarm snoozed"));
+            } else {
+                Serial.println(F("Not enough danger signals to sound the alarm."));
+                alarmStreak = 0;
             }
+            // reset counters following evaluation period
+            dangerCount = 0;
+            sampleCount = 0;
+            lastSampleSetTime = millis();
+            memstatsReport();
         }
     }
+    return false;
+}
+
+bool taskUi() {
+    consolePoll();  // serial commands, never waits for input
+    rollupPoll();  // minute, hour and day aggregates, and the EEPROM history
+    historyPoll();  // at most one EEPROM byte per slice, ~3.4 ms on AVR
+    if (!isDeviceRunning) paramsApplyPending();  // no frames to wait for
+    handleButtonPress();  // handle button interactions to start/stop device and toggle alarm (if required)
+    return false;
 }
 
 /*
 collect samples in all of the x,
 y, and z directions and compute the overall magnitude
-from data pertaining to these three axes...vReal is reset at the start
-of each new sampling set.
+from data pertaining to these three axes...the DC blocker strips the
+gravity offset so only the motion reaches the FFT. the acquire task
+calls this once per sampling period with the grid time the sample
+belongs to and the time the reading started.
 */
-bool collectSamples() {
-    if (micros() - lastTime >= samplingPeriod) {
-        lastTime = micros();
-        double x = CircuitPlayground.motionX();
-        double y = CircuitPlayground.motionY();
-        double z = CircuitPlayground.motionZ();
-        if (index == 0) {
-            for (int i = 0; i < samples; i++) vReal[i] = 0;
-        }
-        vReal[index] = sqrt(x * x + y * y + z * z);
-        index++;
-        if (index >= samples) {
-            index = 0;
-            return true;
-        }
+bool collectSamples(uint32_t gridUs, uint32_t takenUs) {
+    PROFILE_STAGE(STAGE_COLLECT);
+    double x = CircuitPlayground.motionX();
+    double y = CircuitPlayground.motionY();
+    double z = CircuitPlayground.motionZ();
+    // gravity is removed in integer counts before the sample is stored
+    int32_t magnitude = sqrt(x * x + y * y + z * z) * dcScale;
+    int32_t sample = alignToGrid(dcBlockerStep(magnitude), gridUs, takenUs);
+    frames[fillFrame][sampleIndex] = sample > 32767 ? 32767 : (sample < -32768 ? -32768 : sample);
+    sampleIndex++;
+    if (sampleIndex >= samples) {
+        sampleIndex = 0;
+        return true;
     }
     return false;
 }
@@ -119,14 +291,21 @@ bool collectSamples() {
 /*
 perform appropriate FFT computations for incoming accelerometer
 samples...this function is to be later called upon in loop() section for 
-all input values.
+all input values. with welchSegments above 1 the Welch average replaces
+the single periodogram.
+
+each call advances the transform started by dsp.begin() by whole
+steps (a window chunk, the bit reversal, a run of butterflies, ...)
+until fftSliceUs is used up, and returns true once the spectrum is
+ready for analyzeFFT(). a slice overruns the budget by at most one step.
 */
-void performFFT() {
-    memset(vImag, 0, sizeof(vImag));
-    ArduinoFFT<double> FFT = ArduinoFFT<double>(vReal, vImag, samples, samplingFreq);
-    FFT.windowing(FFT_WIN_TYP_HAMMING, FFT_FORWARD);
-    FFT.compute(FFT_FORWARD);
-    FFT.complexToMagnitude();
+bool performFFT() {
+    PROFILE_STAGE(STAGE_FFT);
+    uint32_t start = micros();
+    while (!dsp.step()) {
+        if (micros() - start >= fftSliceUs) return false;
+    }
+    return true;
 }
 
 /*
@@ -136,36 +315,45 @@ frequency is then compared to the 3-6 Hz frequency range since
 that is what is considered to be a Parkinsons tremor.
 */
 double analyzeFFT() {
-    double maxIntensity = 0;
-    for (int i = 1; i < samples / 2; i++) {
-        double frequency = i * samplingFreq / samples;
-        if (frequency >= 3 && frequency <= 6) {
-            maxIntensity = max(maxIntensity, vReal[i]);
-        }
-    }
-    return maxIntensity;
+    PROFILE_STAGE(STAGE_ANALYZE);
+    uint16_t bin = dsp.peakBin(params.bandLowHz, params.bandHighHz, samplingFreq);
+    dominantHz = bin * samplingFreq / dsp.fftSize;
+    return bin ? dsp.magnitude(bin) : 0;
+}
+
+// true once per press, when the button goes down after a settled release
+bool buttonPressed(ButtonState &b, bool down) {
+    uint32_t now = millis();
+    if (down == b.down || now - b.changedMs < buttonDebounceMs) return false;
+    b.down = down;
+    b.changedMs = now;
+    return down;
 }
 
 /*
 handle ON/OFF controls for the entire device,
 as well as for the alarm that sounds. there exist specific
 sounds that play when either button is pressed.
+
+the ui task polls the buttons every 10 ms, so they are debounced by
+time stamp rather than by waiting, and the click sounds go through the
+alarm engine; sampling carries on while a button is handled.
 */
 void handleButtonPress() {
-    if (CircuitPlayground.leftButton()) {
-        delay(200);  // debounce delay
-        CircuitPlayground.playTone(1000, 500);
-        delay(200);  // debounce delay
-        CircuitPlayground.playTone(2000, 500);  // play a 1000 Hz tone for 500 milliseconds
+    PROFILE_STAGE(STAGE_BUTTONS);
+    if (buttonPressed(leftButton, CircuitPlayground.leftButton())) {
+        alarmStart(ALARM_CLICK_POWER);
         CircuitPlayground.clearPixels(); // clear Neopixels to start afresh
+        feedback = FeedbackState();  // the next frame redraws whatever its level
         isDeviceRunning = !isDeviceRunning;
-        Serial.println(isDeviceRunning ? "Device started" : "Device stopped");
+        dcBlockerReset();  // the wearer may have moved while stopped
+        Serial.println(isDeviceRunning ? F("Device started") : F("Device stopped"));
     }
-    if (CircuitPlayground.rightButton()) {
-        delay(200);
-        CircuitPlayground.playTone(2000, 500);
+    if (buttonPressed(rightButton, CircuitPlayground.rightButton())) {
         isAlarmEnabled = !isAlarmEnabled;
-        Serial.println(isAlarmEnabled ? "Alarm enabled" : "Alarm disabled");
+        if (!isAlarmEnabled) alarmStop();
+        alarmStart(ALARM_CLICK_ALARM);
+        Serial.println(isAlarmEnabled ? F("Alarm enabled") : F("Alarm disabled"));
     }
 }
 
@@ -178,13 +366,14 @@ to no movement, and yellows and reds light up progressively as movement samples
 greens - low intensity, "safe"
 yellows - medium intensity, "mild" movement -- could be approaching a tremor
 reds - high intensity, extreme movement, falls in 3-6 Hz range -- is a tremor
-*/
-void updateFeedback(double intensity) {
-    const int lowThreshold = 25;
-    const int highThreshold = 60;
 
+the level comes from feedbackUpdate(), which holds it steady against
+intensities hovering at lowThreshold or highThreshold.
+*/
+void updateFeedback(uint8_t level) {
+    PROFILE_STAGE(STAGE_FEEDBACK);
     uint8_t red, green, blue;
-    if (intensity < lowThreshold) {
+    if (level == FEEDBACK_GREEN) {
         // green color - low intensity
         CircuitPlayground.clearPixels();
         green = 255;
@@ -192,7 +381,7 @@ void updateFeedback(double intensity) {
         blue = 0;
         CircuitPlayground.setPixelColor(4, 0, green, 0);
         CircuitPlayground.setPixelColor(5, 0, green, 0);
-    } else if (intensity >= lowThreshold && intensity < highThreshold) {
+    } else if (level == FEEDBACK_YELLOW) {
         // yellow color - transition from green to red
         CircuitPlayground.clearPixels();
         green = 255;
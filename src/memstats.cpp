@@ -0,0 +1,82 @@
+#include <Arduino.h>
+#include "memstats.h"
+
+#ifdef __AVR__
+
+// linker provided symbols describing the SRAM layout
+extern uint8_t __data_start;
+extern uint8_t _end;
+extern uint8_t __stack;
+extern char *__brkval;
+
+const uint8_t stackPaint = 0xC5;
+uint16_t minFree = 0xFFFF;
+uint16_t stackPeak = 0;
+
+/*
+runs from .init3, after the stack pointer is set up but before any
+constructors or main(), so nothing on the stack is live yet and the
+whole gap between the end of .bss and the top of RAM can be painted.
+*/
+void paintStack() __attribute__((naked, used, section(".init3")));
+void paintStack() {
+    uint8_t *p = &_end;
+    while (p <= &__stack) {
+        *p = stackPaint;
+        p++;
+    }
+}
+
+// lowest address the stack may grow down to without hitting the heap
+static uint8_t *heapTop() {
+    return __brkval ? (uint8_t *)__brkval : &_end;
+}
+
+uint16_t memstatsStaticBytes() {
+    return &_end - &__data_start;
+}
+
+uint16_t memstatsFreeNow() {
+    uint8_t top;  // address of a local approximates the stack pointer
+    return &top - heapTop();
+}
+
+uint16_t memstatsMinFree() {
+    return minFree;
+}
+
+uint16_t memstatsStackPeak() {
+    return stackPeak;
+}
+
+/*
+count the painted bytes sitting directly above the heap...the first
+byte that no longer holds the paint value marks the deepest point the
+stack has ever reached. a stray write into the gap makes the figure
+pessimistic, never optimistic.
+*/
+void memstatsScan() {
+    uint8_t *p = heapTop();
+    while (p <= &__stack && *p == stackPaint) p++;
+    uint16_t untouched = p - heapTop();
+    if (untouched < minFree) minFree = untouched;
+    uint16_t used = &__stack - p + 1;
+    if (used > stackPeak) stackPeak = used;
+}
+
+#else
+
+uint16_t memstatsStaticBytes() { return 0; }
+uint16_t memstatsFreeNow() { return 0; }
+uint16_t memstatsMinFree() { return 0; }
+uint16_t memstatsStackPeak() { return 0; }
+void memstatsScan() {}
+
+#endif
+
+void memstatsReport() {
+    Serial.print(F("SRAM Static: ")); Serial.println(memstatsStaticBytes());
+    Serial.print(F("SRAM Free: ")); Serial.println(memstatsFreeNow());
+    Serial.print(F("Stack Peak: ")); Serial.println(memstatsStackPeak());
+    Serial.print(F("Stack Min Free: ")); Serial.println(memstatsMinFree());
+}
@@ -0,0 +1,52 @@
+#include "params.h"
+#include "dsp_backend.h"
+
+const TuningParams defaultParams = {
+    60.0,            // dangerZoneIntensity
+    0.6,             // dangerRatio
+    2000,            // sampleInterval
+    10 * 60 * 1000UL,  // evaluationPeriod (10 minutes)
+    25.0,            // lowThreshold
+    60.0,            // highThreshold
+    3.0,             // bandLowHz
+    6.0,             // bandHighHz
+    1,               // welchSegments
+};
+
+const double maxBandHz = 25.0;  // Nyquist frequency at the 50 Hz sampling rate
+
+TuningParams params = defaultParams;
+TuningParams pendingParams;
+bool hasPendingParams = false;
+
+bool paramsValid(const TuningParams &p) {
+    if (!(p.dangerZoneIntensity > 0)) return false;
+    if (!(p.dangerRatio > 0 && p.dangerRatio <= 1)) return false;
+    if (p.sampleInterval == 0) return false;
+    if (p.evaluationPeriod < p.sampleInterval) return false;
+    if (!(p.lowThreshold >= 0 && p.lowThreshold < p.highThreshold)) return false;
+    if (!(p.bandLowHz > 0 && p.bandLowHz < p.bandHighHz && p.bandHighHz <= maxBandHz)) return false;
+    // Welch segments must tile the frame at 50% overlap with a power-of-two length
+    if (p.welchSegments != 1 && p.welchSegments != 3 && p.welchSegments != 7 && p.welchSegments != 15) return false;
+    // and the CMSIS kernels only come in some of those lengths
+    if (!SketchDsp::supports(p.welchSegments)) return false;
+    return true;
+}
+
+TuningParams paramsPending() {
+    return hasPendingParams ? pendingParams : params;
+}
+
+bool paramsStage(const TuningParams &p) {
+    if (!paramsValid(p)) return false;
+    pendingParams = p;
+    hasPendingParams = true;
+    return true;
+}
+
+bool paramsApplyPending() {
+    if (!hasPendingParams) return false;
+    params = pendingParams;
+    hasPendingParams = false;
+    return true;
+}
@@ -0,0 +1,99 @@
+#include <Arduino.h>
+#include "profiler.h"
+
+#ifdef ENABLE_PROFILER
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+struct StageStats {
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+};
+
+const char stageNames[STAGE_COUNT][9] PROGMEM = {"buttons", "collect", "fft", "analyze", "feedback"};
+StageStats stageStats[STAGE_COUNT];
+
+#ifdef __AVR__
+
+volatile uint16_t timer1Overflows = 0;
+
+ISR(TIMER1_OVF_vect) {
+    timer1Overflows++;
+}
+
+/*
+Timer1 in normal mode with no prescaler...TCNT1 counts CPU cycles and
+wraps every 65536 of them, the overflow count supplies the upper word.
+*/
+void profilerBegin() {
+    noInterrupts();
+    TCCR1A = 0;
+    TCCR1B = _BV(CS10);
+    TCNT1 = 0;
+    TIFR1 = _BV(TOV1);
+    TIMSK1 = _BV(TOIE1);
+    interrupts();
+    profilerReset();
+}
+
+uint32_t profilerCycles() {
+    uint8_t sreg = SREG;
+    noInterrupts();
+    uint16_t low = TCNT1;
+    uint16_t high = timer1Overflows;
+    // an overflow that happened after interrupts were masked is still pending
+    if ((TIFR1 & _BV(TOV1)) && low < 0x8000) high++;
+    SREG = sreg;
+    return ((uint32_t)high << 16) | low;
+}
+
+#else
+
+void profilerBegin() {
+    profilerReset();
+}
+
+uint32_t profilerCycles() {
+    return micros() * (F_CPU / 1000000UL);
+}
+
+#endif
+
+void profilerRecord(uint8_t stage, uint32_t cycles) {
+    StageStats &s = stageStats[stage];
+    s.count++;
+    s.totalCycles += cycles;
+    if (cycles < s.minCycles) s.minCycles = cycles;
+    if (cycles > s.maxCycles) s.maxCycles = cycles;
+}
+
+void profilerReset() {
+    for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+        stageStats[i].count = 0;
+        stageStats[i].minCycles = 0xFFFFFFFF;
+        stageStats[i].maxCycles = 0;
+        stageStats[i].totalCycles = 0;
+    }
+}
+
+/*
+one line per stage: invocation count and min/max/mean cycles.
+stages that never ran report zeros.
+*/
+void profilerDump() {
+    Serial.print(F("Profile cycles/us: ")); Serial.println(F_CPU / 1000000UL);
+    for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+        const StageStats &s = stageStats[i];
+        Serial.print(F("Profile ")); Serial.print((const __FlashStringHelper *)stageNames[i]);
+        Serial.print(F(": n=")); Serial.print(s.count);
+        Serial.print(F(" min=")); Serial.print(s.count ? s.minCycles : 0);
+        Serial.print(F(" max=")); Serial.print(s.maxCycles);
+        Serial.print(F(" mean=")); Serial.println(s.count ? (uint32_t)(s.totalCycles / s.count) : 0);
+    }
+}
+
+#endif
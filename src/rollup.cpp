@@ -0,0 +1,136 @@
+#include <Arduino.h>
+#include "rollup.h"
+#include "history.h"
+
+const uint32_t minuteMs = 60000;
+
+struct RollupRing {
+    RollupEntry open;    // the unit in progress (the minute, or the closed lower units of this hour / day)
+    uint8_t openUnits;   // closed lower-level units merged into `open`
+    uint8_t head;        // next ring slot to write
+    uint8_t count;       // closed units held
+};
+
+RollupEntry minuteRing[rollupMinutes];
+RollupEntry hourRing[rollupHours];
+RollupEntry dayRing[rollupDays];
+RollupEntry *const rings[ROLLUP_LEVELS] = {minuteRing, hourRing, dayRing};
+RollupRing levels[ROLLUP_LEVELS];
+uint32_t minuteStart = 0;
+
+static void clearEntry(RollupEntry &e) {
+    memset(&e, 0, sizeof(e));
+}
+
+static void merge(RollupEntry &into, const RollupEntry &e) {
+    into.frames += e.frames;
+    into.dangerFrames += e.dangerFrames;
+    into.intensitySum += e.intensitySum;
+    if (e.peak > into.peak || into.frames == e.frames) {
+        into.peak = e.peak;
+        into.peakHz10 = e.peakHz10;
+    }
+}
+
+// the n-th newest closed unit of a level, n = 0 .. count - 1
+static const RollupEntry &closed(uint8_t level, uint8_t n) {
+    const uint8_t size = rollupRing[level];
+    return rings[level][(levels[level].head + size - 1 - n) % size];
+}
+
+void rollupBegin() {
+    for (uint8_t l = 0; l < ROLLUP_LEVELS; l++) {
+        clearEntry(levels[l].open);
+        levels[l].openUnits = 0;
+        levels[l].head = 0;
+        levels[l].count = 0;
+    }
+    minuteStart = millis();
+}
+
+void rollupFrame(double intensity, double dominantHz, bool danger) {
+    RollupEntry frame;
+    frame.frames = 1;
+    frame.dangerFrames = danger;
+    frame.peak = intensity < 0 ? 0 : (intensity > 65535 ? 65535 : (uint16_t)(intensity + 0.5));
+    frame.intensitySum = frame.peak;
+    frame.peakHz10 = dominantHz * 10 > 255 ? 255 : (uint8_t)(dominantHz * 10 + 0.5);
+    merge(levels[ROLLUP_MINUTE].open, frame);
+}
+
+// close the open unit of `level` into its ring and carry it up
+static void closeUnit(uint8_t level) {
+    RollupRing &r = levels[level];
+    rings[level][r.head] = r.open;
+    r.head = (r.head + 1) % rollupRing[level];
+    if (r.count < rollupRing[level]) r.count++;
+    if (level + 1 < ROLLUP_LEVELS) {
+        RollupRing &up = levels[level + 1];
+        merge(up.open, r.open);
+        if (++up.openUnits == rollupPer[level]) {
+            closeUnit(level + 1);
+            up.openUnits = 0;
+            clearEntry(up.open);
+        }
+    }
+    clearEntry(r.open);
+}
+
+void rollupPoll() {
+    if (millis() - minuteStart < minuteMs) return;
+    minuteStart += minuteMs;
+    const RollupEntry &m = levels[ROLLUP_MINUTE].open;
+    historyMinute(m.frames, m.frames ? (m.intensitySum + m.frames / 2) / m.frames : 0, m.peak);
+    closeUnit(ROLLUP_MINUTE);
+}
+
+/*
+level by level from the finest: if the rest of the range fits in the
+closed units this level holds within the open unit above it, those
+units finish the answer; otherwise the open unit above (the same units,
+already merged) is taken whole and the walk moves up a level.
+*/
+uint32_t rollupQuery(uint32_t minutes, RollupEntry &out) {
+    out = levels[ROLLUP_MINUTE].open;
+    uint32_t covered = 0;
+    for (uint8_t l = 0; l < ROLLUP_LEVELS; l++) {
+        const RollupRing &r = levels[l];
+        uint32_t rest = minutes > covered ? minutes - covered : 0;
+        uint32_t units = (rest + rollupSpan[l] - 1) / rollupSpan[l];
+        // closed units of this level inside the open unit of the next one (all of them at the top)
+        uint8_t inside = l + 1 < ROLLUP_LEVELS ? levels[l + 1].openUnits : r.count;
+        if (units <= inside && units <= r.count) {
+            for (uint8_t n = 0; n < units; n++) merge(out, closed(l, n));
+            return covered + units * rollupSpan[l];
+        }
+        if (l + 1 == ROLLUP_LEVELS) {
+            uint8_t n = units < r.count ? units : r.count;
+            for (uint8_t i = 0; i < n; i++) merge(out, closed(l, i));
+            return covered + n * rollupSpan[l];
+        }
+        merge(out, levels[l + 1].open);
+        covered += (uint32_t)inside * rollupSpan[l];
+    }
+    return covered;
+}
+
+bool rollupDay(uint8_t back, RollupEntry &out) {
+    if (back == 0 || back > levels[ROLLUP_DAY].count) return false;
+    out = closed(ROLLUP_DAY, back - 1);
+    return true;
+}
+
+// the open day plus the open hour and minute it does not contain yet
+void rollupToday(RollupEntry &out) {
+    out = levels[ROLLUP_DAY].open;
+    merge(out, levels[ROLLUP_HOUR].open);
+    merge(out, levels[ROLLUP_MINUTE].open);
+}
+
+void rollupPrint(const __FlashStringHelper *label, const RollupEntry &e) {
+    Serial.print(label); Serial.print(F(" Frames: ")); Serial.println(e.frames);
+    Serial.print(label); Serial.print(F(" Mean: ")); Serial.println(e.frames ? (double)e.intensitySum / e.frames : 0.0);
+    Serial.print(label); Serial.print(F(" Peak: ")); Serial.println(e.peak);
+    Serial.print(label); Serial.print(F(" Peak Hz: ")); Serial.println(e.peakHz10 / 10.0);
+    Serial.print(label); Serial.print(F(" Danger: ")); Serial.println(e.frames ? (double)e.dangerFrames / e.frames : 0.0);
+}
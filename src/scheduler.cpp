@@ -0,0 +1,124 @@
+#include <Arduino.h>
+#include "scheduler.h"
+
+struct TaskState {
+    uint32_t release;     // micros() of the pending or next release
+    bool ready;
+    bool started;         // first slice of the current release has run
+    // statistics since the last reset
+    uint32_t runs;        // releases completed
+    uint16_t misses;      // releases whose first slice started late
+    uint16_t skipped;     // periodic releases dropped after falling behind
+    uint32_t maxLatency;  // worst release to first slice delay, us
+    uint32_t maxSlice;    // longest single slice, us
+};
+
+TaskState taskState[schedulerMaxTasks];
+uint8_t scheduledTasks = 0;
+
+static uint32_t periodOf(uint8_t i) {
+    return pgm_read_dword(&tasks[i].periodUs);
+}
+
+void schedulerBegin() {
+    uint32_t now = micros();
+    scheduledTasks = taskCount < schedulerMaxTasks ? taskCount : schedulerMaxTasks;
+    for (uint8_t i = 0; i < scheduledTasks; i++) {
+        TaskState &t = taskState[i];
+        t.release = now + periodOf(i);
+        t.ready = false;
+        t.started = false;
+    }
+    schedulerReset();
+}
+
+// periodic tasks become ready when their release time comes round
+static void releaseDue(uint32_t now) {
+    for (uint8_t i = 0; i < scheduledTasks; i++) {
+        TaskState &t = taskState[i];
+        if (periodOf(i) == 0 || t.ready || (int32_t)(now - t.release) < 0) continue;
+        t.ready = true;
+        t.started = false;
+    }
+}
+
+// the periodic grid moves on once a release is done
+static void finish(uint8_t i, uint32_t now) {
+    TaskState &t = taskState[i];
+    const uint32_t period = periodOf(i);
+    t.ready = false;
+    t.runs++;
+    if (period == 0) return;
+    t.release += period;
+    int32_t behind = now - t.release;
+    if (behind >= (int32_t)period) {
+        uint32_t missed = behind / period;
+        t.skipped += missed;
+        t.release += missed * period;
+    }
+}
+
+void schedulerRun() {
+    for (;;) {
+        uint32_t now = micros();
+        releaseDue(now);
+        uint8_t i = 0;
+        while (i < scheduledTasks && !taskState[i].ready) i++;
+        if (i == scheduledTasks) return;
+
+        TaskState &t = taskState[i];
+        if (!t.started) {
+            uint32_t latency = now - t.release;
+            if (latency > t.maxLatency) t.maxLatency = latency;
+            if (latency > pgm_read_dword(&tasks[i].deadlineUs)) t.misses++;
+            t.started = true;
+        }
+        bool more = ((TaskSlice)pgm_read_ptr(&tasks[i].run))();
+        uint32_t end = micros();
+        if (end - now > t.maxSlice) t.maxSlice = end - now;
+        if (!more) finish(i, end);
+    }
+}
+
+void schedulerRelease(uint8_t task) {
+    TaskState &t = taskState[task];
+    if (t.ready) return;  // already pending, the new event is covered by that run
+    t.release = micros();
+    t.ready = true;
+    t.started = false;
+}
+
+bool schedulerPending(uint8_t task) {
+    return taskState[task].ready;
+}
+
+uint32_t schedulerReleaseTime(uint8_t task) {
+    return taskState[task].release;
+}
+
+void schedulerReset() {
+    for (uint8_t i = 0; i < schedulerMaxTasks; i++) {
+        TaskState &t = taskState[i];
+        t.runs = 0;
+        t.misses = 0;
+        t.skipped = 0;
+        t.maxLatency = 0;
+        t.maxSlice = 0;
+    }
+}
+
+/*
+one line per task: completed releases, deadline misses, skipped
+periodic releases, worst release latency and longest slice in us.
+*/
+void schedulerReport() {
+    for (uint8_t i = 0; i < scheduledTasks; i++) {
+        const TaskState &t = taskState[i];
+        Serial.print(F("Task ")); Serial.print((const __FlashStringHelper *)tasks[i].name);
+        Serial.print(F(": runs=")); Serial.print(t.runs);
+        Serial.print(F(" misses=")); Serial.print(t.misses);
+        Serial.print(F(" skipped=")); Serial.print(t.skipped);
+        Serial.print(F(" latency=")); Serial.print(t.maxLatency);
+        Serial.print(F(" slice=")); Serial.println(t.maxSlice);
+    }
+}
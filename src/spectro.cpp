@@ -0,0 +1,19 @@
+#include <Arduino.h>
+#include "spectro.h"
+
+bool spectroStreaming = false;
+uint16_t spectroSequence = 0;
+
+void spectroSend(const uint8_t *bins) {
+    uint8_t packet[spectroPacketSize];
+    packet[0] = spectroSync0;
+    packet[1] = spectroSync1;
+    packet[2] = spectroTypeFrame;
+    packet[3] = spectroSequence & 0xFF;
+    packet[4] = spectroSequence >> 8;
+    packet[5] = spectroBins;
+    memcpy(packet + 6, bins, spectroBins);
+    packet[spectroPacketSize - 1] = spectroCrc8(packet + 2, spectroPacketSize - 3);
+    Serial.write(packet, spectroPacketSize);
+    spectroSequence++;
+}
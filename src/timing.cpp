@@ -0,0 +1,140 @@
+#include <Arduino.h>
+#include "timing.h"
+
+const uint16_t timingBinEdges[timingBins - 1] = {250, 500, 1000, 2000, 5000, 10000, 20000};
+
+uint32_t timingPeriod = 20000;
+bool timingSequence = false;  // a sample has been taken since the last restart
+uint32_t lastTaken = 0;
+
+// statistics since the last reset
+uint16_t jitterHistogram[timingBins];
+uint32_t samplesTaken = 0;
+uint32_t samplesMissed = 0;
+uint16_t frameOverrunCount = 0;
+uint16_t suspectFrames = 0;
+
+// the frame being collected
+uint32_t frameFirst = 0, frameLast = 0;
+uint16_t frameSamples = 0, frameMissed = 0;
+uint32_t frameMaxLate = 0;
+double lastRate = 0;
+
+// the previous reading, for pulling a late one back to its grid time
+int32_t lastReading = 0;
+uint32_t lastReadingUs = 0;
+bool haveLastReading = false;
+
+void timingBegin(uint32_t periodUs) {
+    timingPeriod = periodUs;
+    timingRestart();
+    timingReset();
+}
+
+void timingRestart() {
+    timingSequence = false;
+    haveLastReading = false;
+    frameSamples = 0;
+    frameMissed = 0;
+    frameMaxLate = 0;
+}
+
+void timingSample(uint32_t releaseUs, uint32_t takenUs) {
+    if (timingSequence) {
+        // samples a period and a half or more apart have at least one missing between them
+        uint32_t gap = takenUs - lastTaken;
+        if (gap >= timingPeriod + timingPeriod / 2) {
+            uint16_t missed = (gap + timingPeriod / 2) / timingPeriod - 1;
+            samplesMissed += missed;
+            frameMissed += missed;
+        }
+        uint32_t late = takenUs - releaseUs;
+        uint8_t bin = 0;
+        while (bin < timingBins - 1 && late >= timingBinEdges[bin]) bin++;
+        if (jitterHistogram[bin] < 0xFFFF) jitterHistogram[bin]++;
+        if (late > frameMaxLate) frameMaxLate = late;
+    }
+    // the first sample after a restart waited for the device to start, not for the loop
+    timingSequence = true;
+    lastTaken = takenUs;
+    if (frameSamples == 0) frameFirst = takenUs;
+    frameLast = takenUs;
+    frameSamples++;
+    samplesTaken++;
+}
+
+/*
+a reading taken more than resampleLateUs after its grid time is
+replaced by the straight line between the previous reading and this
+one, evaluated at the grid time, so every stored sample sits on the
+grid and the bin frequencies stay where analyzeFFT() expects them.
+linear rather than cubic: it needs no reading from the future and a
+single multiply-divide per late sample. the first reading after a
+restart, one whose grid time is not after the previous reading, and
+one more than two periods after it (a missed sample; the frame is
+suspect anyway) are kept as they are.
+
+that bounds the time offset to two periods (40 ms, 16 bits) and the
+step between readings is clamped to int16 like the frames they go
+into, so the product fits 32 bits: no 64-bit arithmetic on the AVR.
+*/
+int32_t alignToGrid(int32_t reading, uint32_t gridUs, uint32_t takenUs) {
+    int32_t aligned = reading;
+    uint32_t late = takenUs - gridUs;
+    uint32_t span = takenUs - lastReadingUs;
+    if (haveLastReading && late > resampleLateUs && (int32_t)(gridUs - lastReadingUs) > 0 && span <= 2 * timingPeriod) {
+        int32_t step = reading - lastReading;
+        if (step > 32767) step = 32767;
+        if (step < -32768) step = -32768;
+        aligned = lastReading + step * (int32_t)(gridUs - lastReadingUs) / (int32_t)span;
+    }
+    lastReading = reading;
+    lastReadingUs = takenUs;
+    haveLastReading = true;
+    return aligned;
+}
+
+bool timingFrameEnd() {
+    lastRate = frameSamples > 1 && frameLast != frameFirst ? (frameSamples - 1) * 1e6 / (frameLast - frameFirst) : 0;
+    bool trusted = frameMissed == 0 && frameMaxLate <= timingLateUs;
+    if (!trusted && suspectFrames < 0xFFFF) suspectFrames++;
+    frameSamples = 0;
+    frameMissed = 0;
+    frameMaxLate = 0;
+    return trusted;
+}
+
+void timingOverrun() {
+    if (frameOverrunCount < 0xFFFF) frameOverrunCount++;
+}
+
+double timingSampleRate() {
+    return lastRate;
+}
+
+void timingReset() {
+    for (uint8_t i = 0; i < timingBins; i++) jitterHistogram[i] = 0;
+    samplesTaken = 0;
+    samplesMissed = 0;
+    frameOverrunCount = 0;
+    suspectFrames = 0;
+}
+
+/*
+totals since the last reset, the last frame's sample rate and the
+lateness histogram as "<edge=count" pairs in us.
+*/
+void timingReport() {
+    Serial.print(F("Timing Samples: ")); Serial.println(samplesTaken);
+    Serial.print(F("Timing Missed: ")); Serial.println(samplesMissed);
+    Serial.print(F("Timing Overruns: ")); Serial.println(frameOverrunCount);
+    Serial.print(F("Timing Suspect Frames: ")); Serial.println(suspectFrames);
+    Serial.print(F("Timing Rate: ")); Serial.println(lastRate);
+    Serial.print(F("Timing Jitter:"));
+    for (uint8_t i = 0; i < timingBins; i++) {
+        Serial.print(i < timingBins - 1 ? F(" <") : F(" >="));
+        Serial.print(timingBinEdges[i < timingBins - 1 ? i : i - 1]);
+        Serial.print(F("=")); Serial.print(jitterHistogram[i]);
+    }
+    Serial.println();
+}
@@ -0,0 +1,42 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <string>
+
+/*
+minimal assertions for the host checks: a failed CHECK prints where and
+what, counts the failure and carries on, so one run reports every
+broken case. main() returns checkResult().
+*/
+
+extern int checkFailures;
+// serial output of the module under test since the last simOutput.clear()
+extern std::string simOutput;
+
+#define CHECK(cond) checkThat((cond), #cond, __FILE__, __LINE__)
+#define CHECK_EQ(a, b) checkEqual((long long)(a), (long long)(b), #a " == " #b, __FILE__, __LINE__)
+
+inline bool checkThat(bool ok, const char *what, const char *file, int line) {
+    if (!ok) {
+        fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+        checkFailures++;
+    }
+    return ok;
+}
+
+inline bool checkEqual(long long a, long long b, const char *what, const char *file, int line) {
+    if (a != b) {
+        fprintf(stderr, "%s:%d: check failed: %s (%lld vs %lld)\n", file, line, what, a, b);
+        checkFailures++;
+    }
+    return a == b;
+}
+
+inline int checkResult(const char *name) {
+    if (checkFailures) fprintf(stderr, "%s: %d check(s) failed\n", name, checkFailures);
+    else printf("%s: ok\n", name);
+    return checkFailures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+the feedback.h level classifier: the first frame after a reset is shown
+at once, a boundary is only crossed feedbackMargin past its threshold,
+a new level needs feedbackDwellFrames frames in a row and a one-frame
+blip is ignored. last, intensity jittering +-3 around each threshold
+for 500 frames must cost only a handful of pixel rewrites where the
+bare thresholds flip hundreds of times.
+*/
+#include <Arduino.h>
+#include "feedback.h"
+#include "check.h"
+
+const double low = 25, high = 60;
+
+static uint8_t rawLevel(double intensity) {
+    return intensity >= high ? FEEDBACK_RED : intensity >= low ? FEEDBACK_YELLOW : FEEDBACK_GREEN;
+}
+
+static void firstFrame() {
+    FeedbackState s;
+    CHECK(feedbackUpdate(s, 70, low, high));
+    CHECK_EQ(s.shown, FEEDBACK_RED);
+
+    // a reset (new FeedbackState) shows its first frame at once too
+    s = FeedbackState();
+    CHECK(feedbackUpdate(s, 10, low, high));
+    CHECK_EQ(s.shown, FEEDBACK_GREEN);
+}
+
+static void margin() {
+    FeedbackState s;
+    feedbackUpdate(s, 10, low, high);
+    // just past the threshold but inside the margin: stays green however long it lasts
+    for (uint8_t i = 0; i < 10; i++) CHECK(!feedbackUpdate(s, low + feedbackMargin - 0.1, low, high));
+    CHECK_EQ(s.shown, FEEDBACK_GREEN);
+
+    CHECK(!feedbackUpdate(s, low + feedbackMargin, low, high));
+    CHECK(feedbackUpdate(s, low + feedbackMargin, low, high));
+    CHECK_EQ(s.shown, FEEDBACK_YELLOW);
+
+    // on the way back the margin applies below the threshold
+    for (uint8_t i = 0; i < 10; i++) CHECK(!feedbackUpdate(s, low - feedbackMargin + 0.1, low, high));
+    CHECK_EQ(s.shown, FEEDBACK_YELLOW);
+    feedbackUpdate(s, low - feedbackMargin - 0.1, low, high);
+    CHECK(feedbackUpdate(s, low - feedbackMargin - 0.1, low, high));
+    CHECK_EQ(s.shown, FEEDBACK_GREEN);
+}
+
+static void dwell() {
+    FeedbackState s;
+    feedbackUpdate(s, 40, low, high);
+    for (uint8_t i = 1; i < feedbackDwellFrames; i++) CHECK(!feedbackUpdate(s, 70, low, high));
+    CHECK_EQ(s.shown, FEEDBACK_YELLOW);
+    CHECK(feedbackUpdate(s, 70, low, high));
+    CHECK_EQ(s.shown, FEEDBACK_RED);
+
+    // a one-frame blip starts the count over
+    CHECK(!feedbackUpdate(s, 40, low, high));
+    CHECK(!feedbackUpdate(s, 70, low, high));
+    CHECK(!feedbackUpdate(s, 40, low, high));
+    CHECK_EQ(s.shown, FEEDBACK_RED);
+
+    // frames asking for two different levels do not add up
+    CHECK(!feedbackUpdate(s, 10, low, high));
+    CHECK_EQ(s.shown, FEEDBACK_RED);
+    CHECK(feedbackUpdate(s, 10, low, high));
+    CHECK_EQ(s.shown, FEEDBACK_GREEN);
+}
+
+static void jumps() {
+    FeedbackState s;
+    feedbackUpdate(s, 10, low, high);
+    CHECK(!feedbackUpdate(s, 90, low, high));
+    CHECK(feedbackUpdate(s, 90, low, high));
+    CHECK_EQ(s.shown, FEEDBACK_RED);
+}
+
+static void jitter() {
+    FeedbackState s;
+    uint32_t seed = 1;
+    uint16_t rawChanges = 0, shownChanges = 0;
+    uint8_t last = FEEDBACK_NONE;
+    for (uint16_t i = 0; i < 1000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        double intensity = (i < 500 ? low - 1 : high + 1) + ((seed >> 16) % 600) / 100.0 - 3;
+        uint8_t raw = rawLevel(intensity);
+        if (raw != last) rawChanges++;
+        last = raw;
+        if (feedbackUpdate(s, intensity, low, high)) shownChanges++;
+    }
+    CHECK(rawChanges > 100);
+    CHECK(shownChanges <= 4);
+    CHECK_EQ(s.shown, FEEDBACK_RED);
+    printf("  jitter: %u raw level changes, %u shown\n", rawChanges, shownChanges);
+}
+
+int main() {
+    firstFrame();
+    margin();
+    dwell();
+    jumps();
+    jitter();
+    return checkResult("feedback");
+}
@@ -0,0 +1,178 @@
+/*
+history.cpp against the simulated EEPROM: the varint / zig-zag entries
+must read back exactly (large steps both ways, full-scale values, long
+gaps), blocks must roll over and the ring wrap, and historyDump() must
+list what survives oldest first, as a contiguous run ending with the
+latest minute. a historyPoll() writes at most one EEPROM byte.
+*/
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <vector>
+#include "history.h"
+#include "check.h"
+
+// the history ring starts here; the calibration slots are not part of these checks
+uint16_t calibrationEnd() {
+    return 160;
+}
+
+const uint8_t ringBlocks = (1024 - 160) / historyBlockSize;
+
+struct Minute {
+    uint16_t frames, mean, peak;
+};
+
+static std::vector<std::string> dump() {
+    simOutput.clear();
+    historyDump();
+    std::vector<std::string> lines;
+    size_t at = 0, end;
+    while ((end = simOutput.find("\r\n", at)) != std::string::npos) {
+        lines.push_back(simOutput.substr(at, end - at));
+        at = end + 2;
+    }
+    return lines;
+}
+
+static std::string entry(const Minute &m) {
+    char text[64];
+    snprintf(text, sizeof(text), "History: %u,%u,%u", m.frames, m.mean, m.peak);
+    return text;
+}
+
+static void eraseEeprom() {
+    memset(EEPROM.cells, 0xFF, sizeof(EEPROM.cells));
+}
+
+// a minute's worth of ui slices, each allowed a single EEPROM write
+static void pollSlices() {
+    for (int i = 0; i < 100; i++) {
+        uint32_t before = EEPROM.writes;
+        historyPoll();
+        if (!CHECK(EEPROM.writes - before <= 1)) return;
+    }
+}
+
+static void codecRoundTrip() {
+    eraseEeprom();
+    historyBegin();
+    const Minute minutes[] = {
+        {23, 100, 140}, {23, 100, 140}, {1, 0, 0}, {65535, 65535, 65535}, {5, 0, 65535},
+        {5, 65535, 0}, {24, 63, 64}, {24, 64, 63}, {12, 8191, 8192}, {12, 8192, 8191},
+    };
+    // no polls here: a block that fills up is finished off by the next minute instead
+    std::vector<std::string> expected = {"History: boot"};
+    for (const Minute &m : minutes) {
+        historyMinute(m.frames, m.mean, m.peak);
+        expected.push_back(entry(m));
+    }
+    // empty minutes collapse into one gap entry once the next minute with frames arrives
+    for (int i = 0; i < 3; i++) historyMinute(0, 0, 0);
+    historyMinute(10, 50, 60);
+    for (int i = 0; i < 300; i++) historyMinute(0, 0, 0);
+    historyMinute(7, 1, 2);
+    expected.push_back("History: gap 3");
+    expected.push_back(entry({10, 50, 60}));
+    expected.push_back("History: gap 300");
+    expected.push_back(entry({7, 1, 2}));
+
+    std::vector<std::string> lines = dump();
+    CHECK_EQ(lines.size(), expected.size());
+    for (size_t i = 0; i < lines.size() && i < expected.size(); i++)
+        if (!CHECK(lines[i] == expected[i])) fprintf(stderr, "  line %zu: '%s', expected '%s'\n", i, lines[i].c_str(), expected[i].c_str());
+}
+
+static void ringWrap() {
+    eraseEeprom();
+    historyBegin();
+    std::vector<std::string> written;
+    for (uint32_t i = 0; i < 2000; i++) {
+        // a wandering trend with an occasional jump, so entries vary in length
+        Minute m = {(uint16_t)(20 + i % 5), (uint16_t)(100 + (i * 7) % 90), (uint16_t)(i % 97 == 0 ? 40000 : 150 + i % 60)};
+        uint32_t before = EEPROM.writes;
+        historyMinute(m.frames, m.mean, m.peak);
+        CHECK_EQ(EEPROM.writes, before);  // the writing is left to historyPoll()
+        written.push_back(entry(m));
+        pollSlices();
+    }
+    std::vector<std::string> lines = dump();
+    // the block holding the boot marker has long been overwritten
+    CHECK(lines.empty() || lines.front() != "History: boot");
+    // every block but the one being refilled holds at least 27 / 7 entries
+    CHECK(lines.size() >= (size_t)(ringBlocks - 1) * 3);
+    CHECK(lines.size() < written.size());
+    size_t first = written.size() - lines.size();
+    for (size_t i = 0; i < lines.size(); i++) {
+        if (!CHECK(lines[i] == written[first + i])) {
+            fprintf(stderr, "  entry %zu: '%s', expected '%s'\n", i, lines[i].c_str(), written[first + i].c_str());
+            break;
+        }
+    }
+}
+
+static void powerCycle() {
+    eraseEeprom();
+    historyBegin();
+    historyMinute(20, 90, 120);
+    historyMinute(21, 95, 130);
+    historyFlush();
+    pollSlices();
+    historyBegin();  // what setup() does after a reset
+    historyMinute(22, 30, 40);
+    std::vector<std::string> lines = dump();
+    std::vector<std::string> expected = {
+        "History: boot", entry({20, 90, 120}), entry({21, 95, 130}), "History: boot", entry({22, 30, 40}),
+    };
+    CHECK(lines == expected);
+
+    // minutes not flushed before the reset are lost, the rest survive
+    historyFlush();
+    pollSlices();
+    historyMinute(23, 31, 41);
+    historyBegin();
+    lines = dump();
+    CHECK_EQ(lines.size(), 6u);
+    CHECK(lines.size() == 6 && lines[4] == entry({22, 30, 40}) && lines[5] == "History: boot");
+
+    historyClear();
+    CHECK(dump().empty());
+}
+
+// a reset part way through a flush keeps the minutes of the previous one, and no garbage
+static void interruptedFlush() {
+    eraseEeprom();
+    historyBegin();
+    historyMinute(20, 90, 120);
+    historyFlush();
+    pollSlices();
+    historyMinute(21, 95, 130);
+    historyMinute(22, 96, 131);
+    historyFlush();
+    historyPoll();
+    historyPoll();  // two of the new entries' bytes are in, the used count is not
+    historyBegin();
+    std::vector<std::string> lines = dump();
+    std::vector<std::string> expected = {"History: boot", entry({20, 90, 120}), "History: boot"};
+    CHECK(lines == expected);
+
+    // a minute closed while a flush is under way is part of what that flush writes
+    historyMinute(23, 97, 132);
+    historyFlush();
+    for (int i = 0; i < 6; i++) historyPoll();  // the entry's 5 bytes and the magic are in, the used count is not
+    historyMinute(24, 98, 133);
+    pollSlices();
+    historyBegin();
+    lines = dump();
+    expected.push_back(entry({23, 97, 132}));
+    expected.push_back(entry({24, 98, 133}));
+    expected.push_back("History: boot");
+    CHECK(lines == expected);
+}
+
+int main() {
+    codecRoundTrip();
+    ringWrap();
+    powerCycle();
+    interruptedFlush();
+    return checkResult("history");
+}
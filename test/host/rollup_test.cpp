@@ -0,0 +1,131 @@
+/*
+rollup.cpp against a reference that keeps every closed minute. frames
+are fed minute by minute for two and a half days, some minutes empty
+(device stopped), and at regular points every rollupQuery() answer is
+compared with the exact aggregate over the open minute plus the number
+of closed minutes it says it covers; that number must reach the asked
+range and overshoot by less than a day. rollupToday(), rollupDay() and
+the minutes handed to the history are checked the same way.
+
+built twice: with the host ring sizes, and with ROLLUP_AVR_RINGS for the
+ATmega32u4's rings, which hold fewer minutes than an hour and fewer
+hours than a day.
+*/
+#include <Arduino.h>
+#include <vector>
+#include "rollup.h"
+#include "check.h"
+
+struct Reference {
+    uint32_t frames = 0, dangerFrames = 0, intensitySum = 0;
+    uint16_t peak = 0;
+    uint8_t peakHz10 = 0;
+
+    void add(const Reference &m) {
+        frames += m.frames;
+        dangerFrames += m.dangerFrames;
+        intensitySum += m.intensitySum;
+        if (m.frames && (frames == m.frames || m.peak > peak)) {
+            peak = m.peak;
+            peakHz10 = m.peakHz10;
+        }
+    }
+};
+
+std::vector<Reference> closedMinutes;
+Reference openMinute;
+std::vector<Reference> historyMinutes;
+
+void historyMinute(uint16_t frames, uint16_t mean, uint16_t peak) {
+    Reference m;
+    m.frames = frames;
+    m.intensitySum = mean;
+    m.peak = peak;
+    historyMinutes.push_back(m);
+}
+
+static void feedFrame(uint16_t intensity, uint8_t hz10) {
+    rollupFrame(intensity, hz10 / 10.0, intensity >= 60);
+    Reference f;
+    f.frames = 1;
+    f.dangerFrames = intensity >= 60;
+    f.intensitySum = intensity;
+    f.peak = intensity;
+    f.peakHz10 = hz10;
+    openMinute.add(f);
+}
+
+// a minute's frames; peaks are distinct from minute to minute so the peak frequency is unambiguous
+static void feedMinute(uint32_t m) {
+    uint8_t frames = m % 11 == 3 ? 0 : 1 + (m * 5) % 23;
+    for (uint8_t j = 0; j < frames; j++) {
+        if (j == frames / 2) feedFrame(1000 + (m * 7919) % 50000, 5 + m % 200);
+        else feedFrame((m * 3 + j * 17) % 900, 30 + j);
+    }
+    simAdvance(60000000ULL);
+    rollupPoll();
+    closedMinutes.push_back(openMinute);
+    openMinute = Reference();
+}
+
+static bool same(const RollupEntry &e, const Reference &r) {
+    return e.frames == r.frames && e.dangerFrames == r.dangerFrames && e.intensitySum == r.intensitySum &&
+           e.peak == r.peak && e.peakHz10 == r.peakHz10;
+}
+
+static Reference lastClosed(uint32_t first, uint32_t count) {
+    Reference r;
+    for (uint32_t i = first; i < first + count; i++) r.add(closedMinutes[i]);
+    return r;
+}
+
+static void checkQueries() {
+    static const uint32_t ranges[] = {1, 2, 4, 5, 6, 10, 59, 60, 61, 90, 180, 360, 361, 420, 1000, 1439, 1440, 1441, 2000, 2880, 3000};
+    const uint32_t total = closedMinutes.size();
+    for (uint32_t minutes : ranges) {
+        RollupEntry e;
+        uint32_t covered = rollupQuery(minutes, e);
+        if (!CHECK(covered <= total)) continue;
+        CHECK(covered >= (minutes < total ? minutes : total));
+        CHECK(covered < minutes + 1440);
+        Reference r = lastClosed(total - covered, covered);
+        r.add(openMinute);
+        if (!CHECK(same(e, r)))
+            fprintf(stderr, "  after %u minutes: trend %u covered %u, frames %u vs %u\n", total, minutes, covered,
+                    e.frames, r.frames);
+    }
+
+    RollupEntry today;
+    rollupToday(today);
+    Reference r = lastClosed(total - total % 1440, total % 1440);
+    r.add(openMinute);
+    CHECK(same(today, r));
+
+    RollupEntry day;
+    uint32_t days = total / 1440;
+    uint8_t kept = days < rollupDays ? days : rollupDays;
+    for (uint8_t back = 1; back <= kept; back++) {
+        if (CHECK(rollupDay(back, day))) CHECK(same(day, lastClosed((days - back) * 1440, 1440)));
+    }
+    CHECK(!rollupDay(kept + 1, day));
+    CHECK(!rollupDay(0, day));
+}
+
+int main() {
+    rollupBegin();
+    for (uint32_t m = 0; m < 3600; m++) {
+        feedMinute(m);
+        if (m % 7 == 0 || m % 60 >= 58 || m % 1440 >= 1438 || m % 1440 == 0) checkQueries();
+        // the open minute counts towards every answer
+        if (m % 13 == 0) feedFrame(m % 900, 40);
+    }
+    checkQueries();
+
+    CHECK_EQ(historyMinutes.size(), closedMinutes.size());
+    for (size_t i = 0; i < historyMinutes.size() && i < closedMinutes.size(); i++) {
+        const Reference &h = historyMinutes[i], &c = closedMinutes[i];
+        uint32_t mean = c.frames ? (c.intensitySum + c.frames / 2) / c.frames : 0;
+        if (!CHECK(h.frames == c.frames && h.intensitySum == mean && h.peak == c.peak)) break;
+    }
+    return checkResult(rollupMinutes < 60 ? "rollup (AVR rings)" : "rollup");
+}
@@ -0,0 +1,50 @@
+/*
+the lib/ArduinoSim hooks without the replay driver: a clock the checks
+move by hand, serial output collected into simOutput and no inputs.
+*/
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "check.h"
+
+int checkFailures = 0;
+std::string simOutput;
+
+SimSerial Serial;
+SimEEPROM EEPROM;
+uint64_t nowUs = 0;
+
+uint64_t simNow() { return nowUs; }
+void simAdvance(uint64_t us) { nowUs += us; }
+SimSample simMotion() { return SimSample{0, 0, 9.81}; }
+bool simLeftPressed() { return false; }
+bool simRightPressed() { return false; }
+bool simSlideSwitch() { return false; }
+int simSerialAvailable() { return 0; }
+int simSerialRead() { return -1; }
+void simSerialWrite(const uint8_t *data, size_t length) { simOutput.append((const char *)data, length); }
+void simTone(uint16_t, uint16_t) {}
+void simPixel(uint8_t, uint8_t, uint8_t, uint8_t) {}
+void simClearPixels() {}
+
+size_t SimSerial::print(long n, int base) {
+    if (n < 0) return print('-') + print((unsigned long)-n, base);
+    return print((unsigned long)n, base);
+}
+
+size_t SimSerial::print(unsigned long n, int base) {
+    char buf[8 * sizeof(long) + 1];
+    char *p = buf + sizeof(buf) - 1;
+    *p = '\0';
+    do {
+        unsigned digit = n % base;
+        *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        n /= base;
+    } while (n);
+    return print(p);
+}
+
+size_t SimSerial::print(double d, int digits) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", digits, d);
+    return print(buf);
+}
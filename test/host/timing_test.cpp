@@ -0,0 +1,86 @@
+/*
+alignToGrid() from timing.cpp: an on-time reading is stored as read, a
+late one is moved onto the straight line from the previous reading to
+its grid time, and the cases with nothing to interpolate from keep the
+reading: the first after timingBegin() or timingRestart(), a grid time
+not after the previous reading, and one after a missed sample. the
+32-bit arithmetic must agree with a 64-bit reference, also across the
+micros() wrap.
+*/
+#include <Arduino.h>
+#include <stdlib.h>
+#include "timing.h"
+#include "check.h"
+
+const uint32_t period = 20000;
+
+// the interpolation the 32-bit version has to match, for steps that fit int16
+static int32_t reference(int32_t previous, uint32_t previousUs, int32_t reading, uint32_t gridUs, uint32_t takenUs) {
+    return previous + (int32_t)((int64_t)(reading - previous) * (int32_t)(gridUs - previousUs) / (int32_t)(takenUs - previousUs));
+}
+
+static void onTimeAndLate() {
+    timingBegin(period);
+    CHECK_EQ(alignToGrid(1000, 0, 100), 1000);  // first reading: nothing to interpolate from
+    CHECK_EQ(alignToGrid(3000, 20000, 20000 + resampleLateUs), 3000);  // not late enough to move
+    // 10 ms late: 19750 of the 29750 us since the previous reading, 3000 + 2000 * 19750 / 29750
+    CHECK_EQ(alignToGrid(5000, 40000, 50000), 4327);
+    // and downwards, rounded towards zero like the 64-bit version: 5000 - 9000 * 10000 / 11000
+    CHECK_EQ(alignToGrid(-4000, 60000, 61000), -3181);
+}
+
+static void firstAfterRestart() {
+    timingBegin(period);
+    alignToGrid(0, 0, 0);
+    alignToGrid(100, 20000, 20000);
+    timingRestart();
+    // late and close enough to interpolate, but the previous reading is from before the stop
+    CHECK_EQ(alignToGrid(9000, 40000, 48000), 9000);
+    CHECK_EQ(alignToGrid(8000, 60000, 68000), 8400);  // 9000 - 1000 * 12000 / 20000
+}
+
+static void nonMonotonic() {
+    timingBegin(period);
+    alignToGrid(100, 0, 0);
+    alignToGrid(200, 20000, 26000);
+    // grid times before and at the previous reading, which came more than a period late
+    CHECK_EQ(alignToGrid(700, 25000, 30000), 700);
+    CHECK_EQ(alignToGrid(800, 30000, 31000), 800);
+    // a missed sample: more than two periods since the previous reading
+    CHECK_EQ(alignToGrid(900, 72000, 73000), 900);
+}
+
+static void matchesReference() {
+    srand(7);
+    uint32_t base = 0xFFFFFFFFu - 5 * period;  // runs across the micros() wrap
+    timingBegin(period);
+    int32_t previous = 0;
+    uint32_t previousUs = base;
+    alignToGrid(previous, base, base);
+    int mismatches = 0;
+    for (uint32_t i = 1; i < 2000; i++) {
+        uint32_t grid = base + i * period;
+        uint32_t taken = grid + rand() % (period - 1);
+        int32_t reading = previous + rand() % 65536 - 32768;
+        int32_t expected = reading;
+        if (taken - grid > resampleLateUs && taken - previousUs <= 2 * period)
+            expected = reference(previous, previousUs, reading, grid, taken);
+        mismatches += alignToGrid(reading, grid, taken) != expected;
+        previous = reading;
+        previousUs = taken;
+    }
+    CHECK_EQ(mismatches, 0);
+
+    // steps beyond int16 are clamped like the frames they end up in
+    timingBegin(period);
+    alignToGrid(0, 0, 0);
+    CHECK_EQ(alignToGrid(100000, 20000, 30000), 21844);  // 32767 * 20000 / 30000
+}
+
+int main() {
+    onTimeAndLate();
+    firstAfterRestart();
+    nonMonotonic();
+    matchesReference();
+    return checkResult("timing");
+}
@@ -0,0 +1,138 @@
+/*
+dsp_bench - per numeric type cost and accuracy of the DSP path.
+
+    dsp_bench [frames] [seed]
+
+runs the same synthetic frames (a 3-12 Hz tremor of 0.05-8 m/s^2 plus
+sensor noise, DC already removed) through TremorDsp<float>, <double>,
+<int16_t> (Q15) and <int32_t> (Q31), and compares every spectrum with
+a long double DFT of the identically windowed frame. host timings only
+rank the types against each other; AVR cycle counts come from the
+on-device profiler (prof).
+
+built as dsp_bench_cmsis (make CMSIS_DSP=<path>), the CMSIS-DSP
+backends the circuitplay_express env uses are measured alongside.
+*/
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "dsp.h"
+#ifdef DSP_BACKEND_CMSIS
+#include "dsp_cmsis.h"
+#endif
+
+const uint16_t frameSize = 128;
+const double samplingFreq = 50.0;
+const uint8_t fracBits = 14;  // same sample format collectSamples() feeds in
+
+struct Frame {
+    std::vector<int32_t> counts;    // DC-blocked samples, 2^fracBits per full scale
+    std::vector<double> reference;  // exact magnitude per bin, m/s^2
+    double referencePeak;           // exact 3-6 Hz intensity
+};
+
+static uint64_t rngState;
+
+static double uniform() {
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return ((rngState * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static Frame makeFrame() {
+    Frame f;
+    double hz = 3 + 9 * uniform();
+    double amp = 0.05 * pow(160.0, uniform());  // log-uniform 0.05 .. 8 m/s^2
+    double phase = 2 * M_PI * uniform();
+    std::vector<long double> x(frameSize);
+    for (uint16_t i = 0; i < frameSize; i++) {
+        double noise = 0.05 * (uniform() + uniform() + uniform() - 1.5);
+        double v = amp * sin(2 * M_PI * hz * i / samplingFreq + phase) + noise;
+        int32_t c = lround(v / dspFullScale * (1 << fracBits));
+        f.counts.push_back(c);
+        long double w = 0.54L - 0.46L * cosl(2 * M_PI * i / frameSize);  // periodic Hamming, as TremorDsp
+        x[i] = (long double)c / (1 << fracBits) * dspFullScale * w;
+    }
+    f.referencePeak = 0;
+    for (uint16_t k = 0; k <= frameSize / 2; k++) {
+        long double re = 0, im = 0;
+        for (uint16_t i = 0; i < frameSize; i++) {
+            re += x[i] * cosl(2 * M_PI * k * i / frameSize);
+            im -= x[i] * sinl(2 * M_PI * k * i / frameSize);
+        }
+        double m = sqrtl(re * re + im * im);
+        f.reference.push_back(m);
+        double hzK = k * samplingFreq / frameSize;
+        if (k > 0 && k < frameSize / 2 && hzK >= 3 && hzK <= 6 && m > f.referencePeak) f.referencePeak = m;
+    }
+    return f;
+}
+
+template <typename Dsp>
+static void bench(const char *name, const std::vector<Frame> &frames) {
+    static Dsp dsp;
+    typedef std::chrono::steady_clock Clock;
+
+    double transformNs = 0, welchNs = 0;
+    double errorSq = 0, signalSq = 0, worstPeak = 0, peakErrorSum = 0;
+    size_t peaks = 0;
+    for (const Frame &f : frames) {
+        for (uint16_t i = 0; i < frameSize; i++) dsp.setSample(i, f.counts[i], fracBits);
+        Clock::time_point t0 = Clock::now();
+        dsp.transform();
+        Clock::time_point t1 = Clock::now();
+        transformNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+
+        for (uint16_t k = 0; k <= frameSize / 2; k++) {
+            double e = dsp.magnitude(k) - f.reference[k];
+            errorSq += e * e;
+            signalSq += f.reference[k] * f.reference[k];
+        }
+        if (f.referencePeak > 1) {
+            double rel = fabs(dsp.bandPeak(3, 6, samplingFreq) - f.referencePeak) / f.referencePeak;
+            peakErrorSum += rel;
+            worstPeak = std::max(worstPeak, rel);
+            peaks++;
+        }
+
+        for (uint16_t i = 0; i < frameSize; i++) dsp.setSample(i, f.counts[i], fracBits);
+        t0 = Clock::now();
+        dsp.welch(3);
+        t1 = Clock::now();
+        welchNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+    }
+
+    size_t n = frames.size();
+    double rmsError = sqrt(errorSq / (n * (frameSize / 2 + 1)));
+    printf("%-9s %6zu %10.0f %10.0f %12.5f %10.1f %11.4f %11.4f\n", name, sizeof(dsp),
+           transformNs / n, welchNs / n, rmsError, 10 * log10(signalSq / errorSq),
+           peaks ? 100 * peakErrorSum / peaks : 0.0, 100 * worstPeak);
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000;
+    rngState = argc > 2 ? strtoull(argv[2], NULL, 10) : 1;
+    if (count == 0 || rngState == 0) {
+        fprintf(stderr, "usage: %s [frames] [seed]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<Frame> frames;
+    for (size_t i = 0; i < count; i++) frames.push_back(makeFrame());
+
+    printf("%zu frames of %u samples, errors against a long double DFT\n", count, frameSize);
+    printf("%-9s %6s %10s %10s %12s %10s %11s %11s\n", "type", "bytes", "fft ns", "welch3 ns",
+           "rms m/s^2", "snr dB", "peak err %", "worst %");
+    bench<TremorDsp<float, frameSize> >("float", frames);
+    bench<TremorDsp<double, frameSize> >("double", frames);
+    bench<TremorDsp<int16_t, frameSize> >("q15", frames);
+    bench<TremorDsp<int32_t, frameSize> >("q31", frames);
+#ifdef DSP_BACKEND_CMSIS
+    bench<CmsisTremorDsp<float, frameSize> >("cmsis-f32", frames);
+    bench<CmsisTremorDsp<int16_t, frameSize> >("cmsis-q15", frames);
+#endif
+    return 0;
+}
@@ -0,0 +1,451 @@
+/*
+fleetd - ingestion daemon for a floor full of devices.
+
+    fleetd [options] [[name=]<serial port | pty | fifo | capture file> ...]
+
+    --listen PORT         also accept device streams on 127.0.0.1:PORT, one
+                          connection per device (a TCP stand-in for USB serial,
+                          e.g. `sim ... | nc localhost PORT`)
+    --workers N           decoding threads (2)
+    --status S            seconds between per-patient status reports (10), 0 = only at exit
+
+one thread owns every descriptor in a single epoll set and does nothing
+but read(); bytes go into a lock-free SPSC ring per device, and a small
+pool of workers (device i belongs to worker i % N) decode the telemetry
+text lines and spectrogram packets out of those rings and keep the state
+of each patient. a full ring stops reading that device until the worker
+catches up, so the kernel buffers the backlog instead of losing frames.
+
+a patient is named by `name=` on the command line, by a `device <name>`
+line sent first on a TCP connection, or by the port path. alarms and
+device start/stop are reported as they happen; the status report gives
+the latest intensity, danger counts and the worker's processing cost per
+frame (an Intensity line or a spectrogram packet). the daemon exits when
+every stream has ended and no --listen socket is open, or on SIGINT.
+*/
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "serial_port.h"
+#include "spectro_decoder.h"
+#include "spsc_queue.h"
+
+const size_t queueSize = 1 << 14;  // ~1.4 s of a 115200 baud link
+const size_t readChunk = 4096;
+
+static uint64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// everything known about one wearer, only touched by the device's worker
+struct PatientState {
+    double intensity = 0;
+    double peakIntensity = 0;
+    double dangerRatio = 0;
+    unsigned long sampleCount = 0;
+    unsigned long dangerCount = 0;
+    uint32_t intensityFrames = 0;
+    uint32_t spectroFrames = 0;
+    uint32_t spectroLost = 0;
+    uint32_t alarms = 0;
+    bool running = false;
+    bool haveSequence = false;
+    uint16_t nextSequence = 0;
+    uint64_t costNs = 0;       // worker time spent decoding
+    uint64_t worstFrameNs = 0; // worst per-frame cost of a single batch
+};
+
+struct Worker;
+
+struct Device {
+    std::string name;
+    int fd = -1;
+    bool pollable = true;       // false for plain files, which epoll refuses
+    bool throttled = false;     // ring full, EPOLLIN switched off
+    Worker *worker = NULL;
+    std::atomic<bool> ended{false};
+    SpscQueue<queueSize> queue;
+    // worker side
+    SpectroDecoder decoder;
+    char line[96];
+    size_t lineFill = 0;
+    bool named = false;
+    PatientState state;
+};
+
+struct Worker {
+    int wake = -1;  // eventfd the I/O thread kicks after queueing bytes
+    std::mutex incomingLock;
+    std::vector<Device *> incoming;  // handed over by the I/O thread, rare
+    std::vector<Device *> devices;
+    std::thread thread;
+};
+
+static std::vector<Worker *> workers;
+static std::mutex outputLock;
+static std::atomic<bool> stopping{false};
+static unsigned statusSeconds = 10;
+
+static void onSignal(int) {
+    stopping.store(true);
+}
+
+static void report(const Device &d) {
+    const PatientState &s = d.state;
+    uint32_t frames = s.intensityFrames + s.spectroFrames;
+    std::lock_guard<std::mutex> lock(outputLock);
+    printf("%s: %s intensity=%.2f peak=%.2f danger=%lu/%lu ratio=%.2f alarms=%u frames=%u spectro=%u lost=%u bad=%u cost_us=%.2f/%.2f\n",
+           d.name.c_str(), s.running ? "running" : "stopped", s.intensity, s.peakIntensity,
+           s.dangerCount, s.sampleCount, s.dangerRatio, s.alarms, s.intensityFrames,
+           s.spectroFrames, s.spectroLost, d.decoder.rejected(),
+           frames ? s.costNs / 1000.0 / frames : 0.0, s.worstFrameNs / 1000.0);
+    fflush(stdout);
+}
+
+static void event(const Device &d, const char *what) {
+    std::lock_guard<std::mutex> lock(outputLock);
+    printf("%s: %s\n", d.name.c_str(), what);
+    fflush(stdout);
+}
+
+// one complete text line; returns true if it ended an intensity frame
+static bool handleLine(Device &d, char *text) {
+    PatientState &s = d.state;
+    if (!d.named && strncmp(text, "device ", 7) == 0) {
+        d.name = text + 7;
+        d.named = true;
+        return false;
+    }
+    d.named = true;  // only the first line may rename the stream
+    // the simulator stamps its output "[hh:mm:ss.mmm] ", skip that
+    if (text[0] == '[') {
+        char *close = strstr(text, "] ");
+        if (close) text = close + 2;
+    }
+    const char *colon = strstr(text, ": ");
+    if (!colon) {
+        if (strcmp(text, "Device started") == 0) { s.running = true; event(d, text); }
+        else if (strcmp(text, "Device stopped") == 0) { s.running = false; event(d, text); }
+        return false;
+    }
+    size_t labelLength = colon - text;
+    const char *value = colon + 2;
+    if (labelLength == 9 && strncmp(text, "Intensity", 9) == 0) {
+        s.intensity = atof(value);
+        if (s.intensity > s.peakIntensity) s.peakIntensity = s.intensity;
+        s.intensityFrames++;
+        s.running = true;
+        return true;
+    }
+    if (labelLength == 12 && strncmp(text, "Sample Count", 12) == 0) s.sampleCount = strtoul(value, NULL, 10);
+    else if (labelLength == 12 && strncmp(text, "Danger Count", 12) == 0) s.dangerCount = strtoul(value, NULL, 10);
+    else if (labelLength == 12 && strncmp(text, "Danger Ratio", 12) == 0) s.dangerRatio = atof(value);
+    else if (labelLength == 14 && strncmp(text, "Alarm sounding", 14) == 0) {
+        s.alarms++;
+        event(d, "ALARM danger level exceeded");
+    }
+    return false;
+}
+
+// decodes whatever is queued for d, returns the number of frames it completed
+static uint32_t drain(Device &d) {
+    uint8_t chunk[1024];
+    uint32_t frames = 0;
+    size_t n;
+    while ((n = d.queue.read(chunk, sizeof(chunk))) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            uint8_t byte = chunk[i];
+            if (d.decoder.push(byte)) {
+                // binary packets can land in the middle of a text line, which stays intact
+                const SpectroDecoder::Frame &f = d.decoder.frame();
+                PatientState &s = d.state;
+                uint16_t gap = f.sequence - s.nextSequence;
+                if (s.haveSequence && gap < 0x8000) s.spectroLost += gap;  // else the device restarted
+                s.nextSequence = f.sequence + 1;
+                s.haveSequence = true;
+                s.spectroFrames++;
+                frames++;
+                continue;
+            }
+            if (d.decoder.inPacket() || byte >= 0x80) continue;
+            if (byte == '\n') {
+                d.line[d.lineFill] = '\0';
+                if (handleLine(d, d.line)) frames++;
+                d.lineFill = 0;
+            } else if (byte != '\r' && d.lineFill < sizeof(d.line) - 1) {
+                d.line[d.lineFill++] = byte;
+            }
+        }
+    }
+    return frames;
+}
+
+static void workerLoop(Worker *w) {
+    uint64_t nextStatus = statusSeconds ? nowNs() + statusSeconds * 1000000000ULL : 0;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(w->incomingLock);
+            w->devices.insert(w->devices.end(), w->incoming.begin(), w->incoming.end());
+            w->incoming.clear();
+        }
+        for (size_t i = 0; i < w->devices.size();) {
+            Device *d = w->devices[i];
+            // read `ended` before draining so no bytes queued ahead of it are missed
+            bool ended = d->ended.load(std::memory_order_acquire);
+            uint64_t start = nowNs();
+            uint32_t frames = drain(*d);
+            if (frames) {
+                uint64_t cost = nowNs() - start;
+                d->state.costNs += cost;
+                if (cost / frames > d->state.worstFrameNs) d->state.worstFrameNs = cost / frames;
+            }
+            if (ended) {
+                report(*d);
+                event(*d, "stream ended");
+                delete d;
+                w->devices[i] = w->devices.back();
+                w->devices.pop_back();
+            } else {
+                i++;
+            }
+        }
+        if (stopping.load() && w->devices.empty()) return;
+        if (nextStatus && nowNs() >= nextStatus) {
+            for (Device *d : w->devices) report(*d);
+            nextStatus += statusSeconds * 1000000000ULL;
+        }
+        // sleep until the I/O thread queues more, or the next status report is due
+        int timeout = -1;
+        if (nextStatus) {
+            uint64_t now = nowNs();
+            timeout = nextStatus > now ? (int)((nextStatus - now) / 1000000) + 1 : 0;
+        }
+        pollfd p = {w->wake, POLLIN, 0};
+        if (poll(&p, 1, timeout) > 0) {
+            uint64_t count;
+            if (read(w->wake, &count, sizeof(count)) < 0) {}
+        }
+    }
+}
+
+static void kick(Worker *w) {
+    uint64_t one = 1;
+    if (write(w->wake, &one, sizeof(one)) < 0) {}
+}
+
+static size_t deviceCount = 0;
+
+static void assign(Device *d) {
+    Worker *w = workers[deviceCount++ % workers.size()];
+    d->worker = w;
+    std::lock_guard<std::mutex> lock(w->incomingLock);
+    w->incoming.push_back(d);
+}
+
+static int listenOn(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) return -1;
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char **argv) {
+    int port = 0;
+    unsigned workerCount = 2;
+    std::vector<std::pair<std::string, std::string>> ports;
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (strcmp(a, "--listen") == 0 && i + 1 < argc) port = atoi(argv[++i]);
+        else if (strcmp(a, "--workers") == 0 && i + 1 < argc) workerCount = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(a, "--status") == 0 && i + 1 < argc) statusSeconds = strtoul(argv[++i], NULL, 10);
+        else if (a[0] == '-' && a[1] == '-') {
+            fprintf(stderr, "usage: %s [--listen PORT] [--workers N] [--status S] [[name=]port ...]\n", argv[0]);
+            return 2;
+        } else {
+            const char *eq = strchr(a, '=');
+            if (eq) ports.push_back({std::string(a, eq - a), eq + 1});
+            else ports.push_back({a, a});
+        }
+    }
+    if (workerCount == 0) workerCount = 1;
+    if (ports.empty() && !port) {
+        fprintf(stderr, "%s: nothing to read, give ports or --listen\n", argv[0]);
+        return 2;
+    }
+
+    int epoll = epoll_create1(0);
+    int listener = -1;
+    if (port) {
+        listener = listenOn(port);
+        if (listener < 0) {
+            fprintf(stderr, "listen %d: %s\n", port, strerror(errno));
+            return 1;
+        }
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.ptr = NULL;  // the only entry without a device
+        epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &ev);
+    }
+
+    // workers get the signal mask as it is now, so only this thread sees SIGINT
+    sigset_t mask, old;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, &old);
+    for (unsigned i = 0; i < workerCount; i++) {
+        Worker *w = new Worker;
+        w->wake = eventfd(0, EFD_NONBLOCK);
+        workers.push_back(w);
+    }
+    for (Worker *w : workers) w->thread = std::thread(workerLoop, w);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    struct sigaction sa = {};
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<Device *> open;  // every device the I/O thread still reads
+    auto add = [&](Device *d) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.ptr = d;
+        if (epoll_ctl(epoll, EPOLL_CTL_ADD, d->fd, &ev) != 0) {
+            if (errno != EPERM) return false;
+            d->pollable = false;  // regular file: always readable, read it between events
+        }
+        open.push_back(d);
+        assign(d);
+        kick(d->worker);
+        return true;
+    };
+    for (auto &p : ports) {
+        Device *d = new Device;
+        d->name = p.first;
+        d->named = true;
+        d->fd = openSerialPort(p.second.c_str(), true);
+        if (d->fd < 0 || !add(d)) {
+            fprintf(stderr, "%s: %s\n", p.second.c_str(), strerror(errno));
+            if (d->fd >= 0) close(d->fd);
+            delete d;
+        }
+    }
+
+    auto finish = [&](Device *d) {
+        if (d->pollable) epoll_ctl(epoll, EPOLL_CTL_DEL, d->fd, NULL);
+        close(d->fd);
+        for (size_t i = 0; i < open.size(); i++) {
+            if (open[i] == d) {
+                open[i] = open.back();
+                open.pop_back();
+                break;
+            }
+        }
+        // the worker owns d from here on and may free it as soon as ended is set
+        Worker *w = d->worker;
+        d->ended.store(true, std::memory_order_release);
+        kick(w);
+    };
+
+    // returns false once the device is finished
+    auto service = [&](Device *d) {
+        uint8_t buffer[readChunk];
+        size_t room = d->queue.space();
+        if (room == 0) {
+            if (d->pollable && !d->throttled) {
+                epoll_event ev = {};
+                ev.data.ptr = d;
+                epoll_ctl(epoll, EPOLL_CTL_MOD, d->fd, &ev);
+            }
+            d->throttled = true;
+            return true;
+        }
+        ssize_t n = read(d->fd, buffer, room < sizeof(buffer) ? room : sizeof(buffer));
+        if (n > 0) {
+            d->queue.write(buffer, n);
+            kick(d->worker);
+            return true;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) return true;
+        finish(d);
+        return false;
+    };
+
+    epoll_event events[64];
+    while (!stopping.load() && (listener >= 0 || !open.empty())) {
+        // throttled devices and plain files need another look without an event
+        bool busy = false;
+        for (Device *d : open) busy |= d->throttled || !d->pollable;
+        int ready = epoll_wait(epoll, events, 64, busy ? 1 : -1);
+        if (ready < 0 && errno != EINTR) break;
+        for (int i = 0; i < ready; i++) {
+            Device *d = (Device *)events[i].data.ptr;
+            if (!d) {
+                int fd;
+                while ((fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+                    d = new Device;
+                    d->name = "tcp" + std::to_string(fd);
+                    d->fd = fd;
+                    if (!add(d)) {
+                        close(fd);
+                        delete d;
+                    }
+                }
+                continue;
+            }
+            service(d);
+        }
+        for (size_t i = 0; i < open.size();) {
+            Device *d = open[i];
+            if (d->throttled && d->queue.space() >= readChunk) {
+                d->throttled = false;
+                if (d->pollable) {
+                    epoll_event ev = {};
+                    ev.events = EPOLLIN;
+                    ev.data.ptr = d;
+                    epoll_ctl(epoll, EPOLL_CTL_MOD, d->fd, &ev);
+                }
+            }
+            if (!d->pollable && !d->throttled && !service(d)) continue;  // finish() removed it
+            i++;
+        }
+    }
+
+    stopping.store(true);
+    while (!open.empty()) finish(open.back());
+    if (listener >= 0) close(listener);
+    for (Worker *w : workers) {
+        kick(w);
+        w->thread.join();
+        close(w->wake);
+        delete w;
+    }
+    close(epoll);
+    return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef SERIAL_PORT_H
+#define SERIAL_PORT_H
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+/*
+open a device's USB serial port (or a PTY standing in for one) in raw
+115200 8N1 mode. anything that is not a terminal (a plain file, a FIFO,
+"-" for stdin) is opened as is so recorded captures replay through the
+same path. returns -1 on failure with errno set.
+*/
+inline int openSerialPort(const char *path, bool nonBlocking = false) {
+    int fd = (path[0] == '-' && path[1] == '\0') ? dup(STDIN_FILENO)
+                                                  : open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0) return -1;
+    if (isatty(fd)) {
+        termios tio;
+        if (tcgetattr(fd, &tio) == 0) {
+            cfmakeraw(&tio);
+            cfsetispeed(&tio, B115200);
+            cfsetospeed(&tio, B115200);
+            tio.c_cc[VMIN] = 1;
+            tio.c_cc[VTIME] = 0;
+            tcsetattr(fd, TCSANOW, &tio);
+        }
+    }
+    if (nonBlocking) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+#endif
@@ -0,0 +1,278 @@
+#ifndef SESSION_FORMAT_H
+#define SESSION_FORMAT_H
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/*
+columnar session files (.tses). a recorded wear session is kept as
+independent integer columns rather than text lines, so a tool that only
+wants intensity never touches the raw axes:
+
+    "TSES" version columnCount   8 byte header
+    column blocks                 back to back, in any order
+    footer                        per column: name, scale, rows, block index
+    footerOffset footerBytes "TSEF"   16 byte trailer
+
+each block holds up to sessionBlockRows values of one column, stored as
+the first value then successive differences, zigzag encoded as LEB128
+varints. accelerometer and time columns move slowly from row to row, so
+most values take one or two bytes. the block index keeps each block's
+first row and min/max, so a reader can seek to a time range or skip
+blocks that cannot match a filter without decoding them. time columns
+sampled at a fixed rate are stored as second differences instead, which
+makes a steady clock one zero byte per row. a stored value v stands for
+v * scale in the column's unit.
+*/
+
+const uint32_t sessionMagic = 0x53455354;    // "TSES"
+const uint32_t sessionEndMagic = 0x46455354; // "TSEF"
+const uint16_t sessionVersion = 1;
+const uint32_t sessionBlockRows = 4096;
+const size_t sessionNameLength = 16;
+
+struct SessionBlock {
+    uint64_t offset;    // from the start of the file
+    uint64_t firstRow;
+    uint32_t bytes;
+    uint32_t rows;
+    int64_t min;
+    int64_t max;
+};
+
+struct SessionColumnInfo {
+    char name[sessionNameLength];
+    double scale;
+    uint64_t rows;
+    uint32_t blockCount;
+    uint32_t order;     // 1: differences stored, 2: differences of differences
+};
+
+struct SessionTrailer {
+    uint64_t footerOffset;
+    uint32_t footerBytes;
+    uint32_t magic;
+};
+
+inline uint64_t sessionZigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+inline int64_t sessionUnzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+/*
+collects whole columns in memory and writes the file in one go at
+finish(). a session at 50 Hz is a few MB of int64 before encoding, which
+is nothing on the host.
+*/
+class SessionWriter {
+public:
+    // returns the column's id for append(); order 2 suits fixed-rate timestamps
+    size_t addColumn(const char *name, double scale, uint32_t order = 1) {
+        Column c;
+        memset(c.info.name, 0, sizeof(c.info.name));
+        strncpy(c.info.name, name, sizeof(c.info.name) - 1);
+        c.info.scale = scale;
+        c.info.order = order == 2 ? 2 : 1;
+        columns.push_back(c);
+        return columns.size() - 1;
+    }
+
+    void append(size_t column, int64_t value) { columns[column].values.push_back(value); }
+
+    bool finish(const char *path) {
+        FILE *f = fopen(path, "wb");
+        if (!f) return false;
+        uint32_t header[2] = {sessionMagic, sessionVersion | (uint32_t)columns.size() << 16};
+        fwrite(header, sizeof(header), 1, f);
+        uint64_t offset = sizeof(header);
+        std::vector<uint8_t> encoded;
+        for (Column &c : columns) {
+            c.blocks.clear();
+            for (size_t first = 0; first < c.values.size(); first += sessionBlockRows) {
+                size_t rows = c.values.size() - first < sessionBlockRows ? c.values.size() - first : sessionBlockRows;
+                SessionBlock b = {offset, first, 0, (uint32_t)rows, c.values[first], c.values[first]};
+                encoded.clear();
+                int64_t previous = 0, step = 0;
+                for (size_t i = first; i < first + rows; i++) {
+                    int64_t v = c.values[i];
+                    if (v < b.min) b.min = v;
+                    if (v > b.max) b.max = v;
+                    int64_t delta = v - previous;
+                    uint64_t z = sessionZigzag(c.info.order == 2 ? delta - step : delta);
+                    previous = v;
+                    step = delta;
+                    while (z >= 0x80) {
+                        encoded.push_back((uint8_t)z | 0x80);
+                        z >>= 7;
+                    }
+                    encoded.push_back((uint8_t)z);
+                }
+                b.bytes = encoded.size();
+                fwrite(encoded.data(), 1, encoded.size(), f);
+                offset += encoded.size();
+                c.blocks.push_back(b);
+            }
+            c.info.rows = c.values.size();
+            c.info.blockCount = c.blocks.size();
+        }
+        // the footer is read in place from the mapping, so keep it aligned
+        static const uint8_t padding[8] = {0};
+        fwrite(padding, 1, (8 - offset % 8) % 8, f);
+        offset += (8 - offset % 8) % 8;
+        SessionTrailer trailer = {offset, 0, sessionEndMagic};
+        for (Column &c : columns) {
+            fwrite(&c.info, sizeof(c.info), 1, f);
+            fwrite(c.blocks.data(), sizeof(SessionBlock), c.blocks.size(), f);
+            trailer.footerBytes += sizeof(c.info) + sizeof(SessionBlock) * c.blocks.size();
+        }
+        fwrite(&trailer, sizeof(trailer), 1, f);
+        return fclose(f) == 0;
+    }
+
+private:
+    struct Column {
+        SessionColumnInfo info;
+        std::vector<int64_t> values;
+        std::vector<SessionBlock> blocks;
+    };
+    std::vector<Column> columns;
+};
+
+/*
+read side. the whole file is mapped read-only and nothing is decoded
+until a block is asked for, so the pages of columns nobody reads are
+never faulted in.
+*/
+class SessionReader {
+public:
+    struct Column {
+        const SessionColumnInfo *info;
+        const SessionBlock *blocks;
+    };
+
+    ~SessionReader() {
+        if (map) munmap((void *)map, size);
+    }
+
+    // false if the file is missing or not a complete session file
+    bool open(const char *path) {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0 && st.st_size >= (off_t)(8 + sizeof(SessionTrailer));
+        if (ok) {
+            size = st.st_size;
+            void *m = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            map = m == MAP_FAILED ? NULL : (const uint8_t *)m;
+        }
+        ::close(fd);
+        return map && index();
+    }
+
+    size_t columnCount() const { return columns.size(); }
+    const Column &column(size_t i) const { return columns[i]; }
+
+    // index of the named column, or -1
+    int find(const char *name) const {
+        for (size_t i = 0; i < columns.size(); i++)
+            if (strncmp(columns[i].info->name, name, sessionNameLength) == 0) return i;
+        return -1;
+    }
+
+    // decodes one block of column c into out (room for block.rows values); false if the block is corrupt
+    bool decode(const Column &c, const SessionBlock &block, int64_t *out) const {
+        // index() checked that the block lies inside the data area
+        const uint8_t *p = map + block.offset, *end = p + block.bytes;
+        int64_t value = 0, step = 0;
+        for (uint32_t i = 0; i < block.rows; i++) {
+            uint64_t z = 0;
+            uint8_t shift = 0;
+            uint8_t byte;
+            do {
+                // a varint is at most 10 bytes and may not run past its block
+                if (p == end || shift > 63) return false;
+                byte = *p++;
+                z |= (uint64_t)(byte & 0x7F) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+            if (c.info->order == 2) step += sessionUnzigzag(z);
+            else step = sessionUnzigzag(z);
+            value += step;
+            out[i] = value;
+        }
+        return true;
+    }
+
+    // every value of a column, for tools that want it all; false if a block is corrupt
+    bool read(size_t i, std::vector<int64_t> &values) const {
+        const Column &c = columns[i];
+        values.assign(c.info->rows, 0);
+        for (uint32_t b = 0; b < c.info->blockCount; b++)
+            if (!decode(c, c.blocks[b], values.data() + c.blocks[b].firstRow)) return false;
+        return true;
+    }
+
+    size_t fileSize() const { return size; }
+
+private:
+    const uint8_t *map = NULL;
+    size_t size = 0;
+    std::vector<Column> columns;
+
+    /*
+    everything below is read in place from the mapping, so each column
+    entry, its block table and every block it points at are checked
+    against the file before anything is handed out. blocks must tile
+    the column the way SessionWriter lays them out, which is what lets
+    decode() write block.rows values and session_scan line up columns
+    of equal length block by block.
+    */
+    bool index() {
+        uint32_t header[2];
+        memcpy(header, map, sizeof(header));
+        SessionTrailer trailer;
+        memcpy(&trailer, map + size - sizeof(trailer), sizeof(trailer));
+        if (header[0] != sessionMagic || (header[1] & 0xFFFF) != sessionVersion || trailer.magic != sessionEndMagic)
+            return false;
+        size_t footerEnd = size - sizeof(trailer);
+        if (trailer.footerOffset < sizeof(header) || trailer.footerOffset % 8 != 0 ||
+            trailer.footerOffset > footerEnd || trailer.footerBytes != footerEnd - trailer.footerOffset)
+            return false;
+        size_t at = trailer.footerOffset;
+        for (uint16_t i = 0; i < header[1] >> 16; i++) {
+            Column c;
+            if (footerEnd - at < sizeof(SessionColumnInfo)) return false;
+            c.info = (const SessionColumnInfo *)(map + at);
+            at += sizeof(SessionColumnInfo);
+            uint64_t rows = c.info->rows;
+            if (c.info->blockCount != (rows + sessionBlockRows - 1) / sessionBlockRows) return false;
+            if ((footerEnd - at) / sizeof(SessionBlock) < c.info->blockCount) return false;
+            c.blocks = (const SessionBlock *)(map + at);
+            at += sizeof(SessionBlock) * c.info->blockCount;
+            for (uint32_t b = 0; b < c.info->blockCount; b++) {
+                const SessionBlock &block = c.blocks[b];
+                uint64_t first = (uint64_t)b * sessionBlockRows;
+                if (block.firstRow != first || block.rows != std::min<uint64_t>(sessionBlockRows, rows - first))
+                    return false;
+                if (block.offset < sizeof(header) || block.offset > trailer.footerOffset ||
+                    block.bytes > trailer.footerOffset - block.offset)
+                    return false;
+            }
+            columns.push_back(c);
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,105 @@
+/*
+session_pack - turn a recorded session into a columnar .tses file.
+
+    session_pack <trace.csv> [telemetry.log] <out.tses> [--danger I]
+
+trace.csv is the accelerometer recording in the replay format
+("t_us,x,y,z[,label]", events starting with '@' are skipped) and becomes
+the sample columns t_us, x, y, z (mm/s^2) and label. telemetry.log is the
+device's serial output for the same session; each "Intensity:" line
+becomes a row of the frame columns frame_t_us, intensity (0.01 m/s^2)
+and danger (intensity at or above --danger, default 60). frame times come
+from the simulator's "[hh:mm:ss.mmm]" stamps when present, else from
+the 128 sample / 50 Hz frame period.
+
+see tools/session_format.h for the layout and session_scan for reading.
+*/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "session_format.h"
+
+const double framePeriodUs = 128 / 50.0 * 1e6;
+
+int main(int argc, char **argv) {
+    double danger = 60.0;
+    std::vector<const char *> paths;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--danger") == 0 && i + 1 < argc) danger = atof(argv[++i]);
+        else paths.push_back(argv[i]);
+    }
+    if (paths.size() < 2 || paths.size() > 3) {
+        fprintf(stderr, "usage: %s <trace.csv> [telemetry.log] <out.tses> [--danger I]\n", argv[0]);
+        return 2;
+    }
+
+    SessionWriter writer;
+    size_t t = writer.addColumn("t_us", 1e-6, 2);
+    size_t x = writer.addColumn("x", 1e-3);
+    size_t y = writer.addColumn("y", 1e-3);
+    size_t z = writer.addColumn("z", 1e-3);
+    size_t label = writer.addColumn("label", 1);
+
+    FILE *trace = fopen(paths[0], "r");
+    if (!trace) {
+        fprintf(stderr, "%s: cannot open\n", paths[0]);
+        return 1;
+    }
+    char line[256];
+    unsigned long samples = 0;
+    bool labelled = true;
+    while (fgets(line, sizeof(line), trace)) {
+        if (line[0] == '@' || line[0] == '#') continue;
+        double us, ax, ay, az;
+        int l = 0;
+        int fields = sscanf(line, "%lf,%lf,%lf,%lf,%d", &us, &ax, &ay, &az, &l);
+        if (fields < 4) continue;
+        labelled &= fields == 5;
+        writer.append(t, llround(us));
+        writer.append(x, llround(ax * 1000));
+        writer.append(y, llround(ay * 1000));
+        writer.append(z, llround(az * 1000));
+        writer.append(label, l);
+        samples++;
+    }
+    fclose(trace);
+    if (!labelled) fprintf(stderr, "%s: not every sample has a label, missing ones are 0\n", paths[0]);
+
+    unsigned long frames = 0;
+    if (paths.size() == 3) {
+        size_t frameTime = writer.addColumn("frame_t_us", 1e-6, 2);
+        size_t intensity = writer.addColumn("intensity", 0.01);
+        size_t flag = writer.addColumn("danger", 1);
+        FILE *log = fopen(paths[1], "r");
+        if (!log) {
+            fprintf(stderr, "%s: cannot open\n", paths[1]);
+            return 1;
+        }
+        while (fgets(line, sizeof(line), log)) {
+            int h, m, s, ms;
+            const char *text = line;
+            double us = frames * framePeriodUs;
+            if (sscanf(line, "[%d:%d:%d.%d] ", &h, &m, &s, &ms) == 4) {
+                us = ((h * 60.0 + m) * 60 + s) * 1e6 + ms * 1e3;
+                text = strstr(line, "] ") + 2;
+            }
+            // packets from `stream on` can share the line, so search rather than match the start
+            const char *found = strstr(text, "Intensity: ");
+            if (!found) continue;
+            double v = atof(found + 11);
+            writer.append(frameTime, llround(us));
+            writer.append(intensity, llround(v * 100));
+            writer.append(flag, v >= danger);
+            frames++;
+        }
+        fclose(log);
+    }
+
+    if (!writer.finish(paths.back())) {
+        fprintf(stderr, "%s: write failed\n", paths.back());
+        return 1;
+    }
+    fprintf(stderr, "%lu samples, %lu frames\n", samples, frames);
+    return 0;
+}
@@ -0,0 +1,122 @@
+/*
+session_scan - read columns out of a .tses session file.
+
+    session_scan <file.tses>                    column table and compression
+    session_scan <file.tses> col [col ...]      those columns as CSV, scaled to units
+    session_scan <file.tses> --stats col        min/max/mean of one column and decode speed
+    session_scan <file.tses> --from S --to S col [col ...]
+
+--from/--to select rows by the first column's value in seconds (it must
+be a time column such as t_us or frame_t_us); blocks entirely outside
+the range are skipped using the footer index without being decoded.
+*/
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "session_format.h"
+
+static int usage(const char *self) {
+    fprintf(stderr, "usage: %s <file.tses> [--stats] [--from S] [--to S] [column ...]\n", self);
+    return 2;
+}
+
+static int corrupt(const char *path) {
+    fprintf(stderr, "%s: corrupt block\n", path);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) return usage(argv[0]);
+    SessionReader session;
+    if (!session.open(argv[1])) {
+        fprintf(stderr, "%s: not a session file\n", argv[1]);
+        return 1;
+    }
+
+    bool stats = false;
+    double from = -1e300, to = 1e300;
+    std::vector<int> selected;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--stats") == 0) stats = true;
+        else if (strcmp(argv[i], "--from") == 0 && i + 1 < argc) from = atof(argv[++i]);
+        else if (strcmp(argv[i], "--to") == 0 && i + 1 < argc) to = atof(argv[++i]);
+        else if (argv[i][0] == '-') return usage(argv[0]);
+        else {
+            int c = session.find(argv[i]);
+            if (c < 0) {
+                fprintf(stderr, "%s: no column %s\n", argv[1], argv[i]);
+                return 1;
+            }
+            selected.push_back(c);
+        }
+    }
+
+    if (selected.empty()) {
+        printf("%-16s %10s %8s %12s %10s\n", "column", "rows", "blocks", "bytes", "bytes/row");
+        for (size_t c = 0; c < session.columnCount(); c++) {
+            const SessionReader::Column &col = session.column(c);
+            uint64_t bytes = 0;
+            for (uint32_t b = 0; b < col.info->blockCount; b++) bytes += col.blocks[b].bytes;
+            printf("%-16.16s %10llu %8u %12llu %10.2f\n", col.info->name, (unsigned long long)col.info->rows,
+                   col.info->blockCount, (unsigned long long)bytes, col.info->rows ? (double)bytes / col.info->rows : 0.0);
+        }
+        printf("file %zu bytes\n", session.fileSize());
+        return 0;
+    }
+
+    if (stats) {
+        const SessionReader::Column &col = session.column(selected[0]);
+        std::vector<int64_t> values(sessionBlockRows);
+        int64_t min = INT64_MAX, max = INT64_MIN;
+        long double sum = 0;
+        uint64_t bytes = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t b = 0; b < col.info->blockCount; b++) {
+            const SessionBlock &block = col.blocks[b];
+            if (!session.decode(col, block, values.data())) return corrupt(argv[1]);
+            for (uint32_t i = 0; i < block.rows; i++) sum += values[i];
+            if (block.min < min) min = block.min;
+            if (block.max > max) max = block.max;
+            bytes += block.bytes;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double scale = col.info->scale;
+        uint64_t rows = col.info->rows;
+        printf("%s: rows=%llu min=%g max=%g mean=%g\n", col.info->name, (unsigned long long)rows,
+               min * scale, max * scale, rows ? (double)(sum / rows) * scale : 0.0);
+        printf("decoded %llu bytes in %.3f ms (%.0f Mrows/s)\n", (unsigned long long)bytes, seconds * 1e3,
+               seconds > 0 ? rows / seconds / 1e6 : 0.0);
+        return 0;
+    }
+
+    // CSV of rows whose first selected column lies in [from, to]
+    const SessionReader::Column &key = session.column(selected[0]);
+    for (int c : selected) {
+        if (session.column(c).info->rows != key.info->rows) {
+            fprintf(stderr, "%s: columns %s and %s have different row counts\n", argv[1], key.info->name,
+                    session.column(c).info->name);
+            return 1;
+        }
+    }
+    for (size_t i = 0; i < selected.size(); i++)
+        printf("%s%.16s", i ? "," : "", session.column(selected[i]).info->name);
+    printf("\n");
+    std::vector<std::vector<int64_t>> values(selected.size(), std::vector<int64_t>(sessionBlockRows));
+    for (uint32_t b = 0; b < key.info->blockCount; b++) {
+        const SessionBlock &block = key.blocks[b];
+        if (block.max * key.info->scale < from || block.min * key.info->scale > to) continue;
+        // columns are blocked the same way when their row counts match
+        for (size_t i = 0; i < selected.size(); i++)
+            if (!session.decode(session.column(selected[i]), session.column(selected[i]).blocks[b], values[i].data()))
+                return corrupt(argv[1]);
+        for (uint32_t r = 0; r < block.rows; r++) {
+            double k = values[0][r] * key.info->scale;
+            if (k < from || k > to) continue;
+            for (size_t i = 0; i < selected.size(); i++)
+                printf("%s%.10g", i ? "," : "", values[i][r] * session.column(selected[i]).info->scale);
+            printf("\n");
+        }
+    }
+    return 0;
+}
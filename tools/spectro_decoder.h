@@ -0,0 +1,78 @@
+#ifndef SPECTRO_DECODER_H
+#define SPECTRO_DECODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "spectro.h"
+
+/*
+incremental decoder for the spectrogram packets described in
+include/spectro.h. bytes are pushed one at a time as they arrive; text
+telemetry interleaved on the same line is skipped while hunting for the
+sync pair, and a packet is only reported once its CRC matches. a
+rejected packet is not thrown away whole: decoding resumes at the next
+sync pair inside it, in case a real packet started there (a lost byte
+or a sync pair in the text can otherwise swallow the next packet).
+*/
+class SpectroDecoder {
+public:
+    struct Frame {
+        uint16_t sequence;
+        uint8_t bins[spectroBins];
+    };
+
+    // true when `byte` completed a valid packet, now available in frame()
+    bool push(uint8_t byte) {
+        if (fill == 0) {
+            if (byte == spectroSync0) packet[fill++] = byte;
+            return false;
+        }
+        if (fill == 1) {
+            if (byte == spectroSync1) packet[fill++] = byte;
+            else fill = (byte == spectroSync0) ? 1 : 0;
+            return false;
+        }
+        packet[fill++] = byte;
+        if (fill == 6 && !headerOk()) {
+            reject();
+            return false;
+        }
+        if (fill < spectroPacketSize) return false;
+        if (spectroCrc8(packet + 2, spectroPacketSize - 3) != packet[spectroPacketSize - 1]) {
+            reject();
+            return false;
+        }
+        fill = 0;
+        current.sequence = packet[3] | (packet[4] << 8);
+        for (uint8_t i = 0; i < spectroBins; i++) current.bins[i] = packet[6 + i];
+        return true;
+    }
+
+    const Frame &frame() const { return current; }
+    // true while bytes are being taken as part of a packet rather than text
+    bool inPacket() const { return fill > 0; }
+    uint32_t rejected() const { return badPackets; }
+
+private:
+    bool headerOk() const { return packet[2] == spectroTypeFrame && packet[5] == spectroBins; }
+
+    // count the packet taken so far as bad and keep what follows its first byte from the next sync pair on
+    void reject() {
+        badPackets++;
+        do {
+            size_t from = 1;
+            while (from < fill && !(packet[from] == spectroSync0 && (from + 1 == fill || packet[from + 1] == spectroSync1)))
+                from++;
+            memmove(packet, packet + from, fill - from);
+            fill -= from;
+        } while (fill >= 6 && !headerOk());
+    }
+
+    uint8_t packet[spectroPacketSize];
+    size_t fill = 0;
+    Frame current = {};
+    uint32_t badPackets = 0;
+};
+
+#endif
@@ -0,0 +1,108 @@
+/*
+spectro_rx - host side receiver for the device's spectrogram stream.
+
+    spectro_rx <serial port | capture file | -> <out.spg> [rows]
+
+reads packets (enable them on the device with `stream on`) and keeps a
+rolling spectrogram of the last `rows` frames (default 4096, about three
+hours at 50 Hz / 128 samples) in a memory-mapped file. viewers can map
+the same file read-only and follow `frames` to see new rows as they
+land. frames lost on the wire are written as zero rows so the time axis
+stays true.
+*/
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "serial_port.h"
+#include "spectro_decoder.h"
+
+const uint32_t spgMagic = 0x47505354;  // "TSPG"
+const uint16_t spgVersion = 1;
+
+// file layout: this header, then `rows` rows of `bins` log-magnitude bytes
+struct SpgHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t bins;
+    uint8_t firstBin;
+    float binHz;          // width of one 128-point bin
+    float logScale;       // codes per doubling, magnitude = 2^(q / logScale) - 1
+    uint32_t rows;        // ring capacity
+    uint32_t dropped;     // frames missing from the sequence
+    uint64_t frames;      // rows written so far, next row is frames % rows
+};
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <serial port | capture file | -> <out.spg> [rows]\n", argv[0]);
+        return 2;
+    }
+    uint32_t rows = argc > 3 ? strtoul(argv[3], NULL, 10) : 4096;
+    if (rows == 0) rows = 1;
+
+    int in = openSerialPort(argv[1]);
+    if (in < 0) {
+        fprintf(stderr, "%s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+    int out = open(argv[2], O_RDWR | O_CREAT | O_TRUNC, 0644);
+    size_t fileSize = sizeof(SpgHeader) + (size_t)rows * spectroBins;
+    if (out < 0 || ftruncate(out, fileSize) != 0) {
+        fprintf(stderr, "%s: %s\n", argv[2], strerror(errno));
+        return 1;
+    }
+    uint8_t *map = (uint8_t *)mmap(NULL, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, out, 0);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "mmap: %s\n", strerror(errno));
+        return 1;
+    }
+
+    SpgHeader *header = (SpgHeader *)map;
+    uint8_t *ring = map + sizeof(SpgHeader);
+    header->magic = spgMagic;
+    header->version = spgVersion;
+    header->bins = spectroBins;
+    header->firstBin = spectroFirstBin;
+    header->binHz = 50.0f / 128;
+    header->logScale = spectroLogScale;
+    header->rows = rows;
+    header->dropped = 0;
+    header->frames = 0;
+
+    SpectroDecoder decoder;
+    bool haveSequence = false;
+    uint16_t expected = 0;
+    uint8_t buffer[512];
+    ssize_t n;
+    while ((n = read(in, buffer, sizeof(buffer))) > 0 || (n < 0 && errno == EINTR)) {
+        for (ssize_t i = 0; i < n; i++) {
+            if (!decoder.push(buffer[i])) continue;
+            const SpectroDecoder::Frame &f = decoder.frame();
+            // a short gap is filled with empty rows, a long one is a device restart
+            uint16_t gap = haveSequence ? (uint16_t)(f.sequence - expected) : 0;
+            if (gap > 0 && gap < rows) {
+                header->dropped += gap;
+                for (uint16_t g = 0; g < gap; g++) {
+                    memset(ring + (header->frames % rows) * spectroBins, 0, spectroBins);
+                    header->frames++;
+                }
+            }
+            memcpy(ring + (header->frames % rows) * spectroBins, f.bins, spectroBins);
+            // publish the row before advancing the counter readers poll
+            __atomic_store_n(&header->frames, header->frames + 1, __ATOMIC_RELEASE);
+            expected = f.sequence + 1;
+            haveSequence = true;
+        }
+    }
+
+    fprintf(stderr, "%llu frames, %u dropped, %u bad packets\n",
+            (unsigned long long)header->frames, header->dropped, decoder.rejected());
+    msync(map, fileSize, MS_SYNC);
+    munmap(map, fileSize);
+    close(out);
+    close(in);
+    return 0;
+}
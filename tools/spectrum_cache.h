@@ -0,0 +1,178 @@
+#ifndef SPECTRUM_CACHE_H
+#define SPECTRUM_CACHE_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+/*
+content-addressed cache of per-frame spectra for the host tools. the
+FFT of a recording only depends on the recording's bytes and the DSP
+configuration, never on the thresholds, so re-tuning runs can skip
+straight to the band peaks.
+
+an entry's name is a 64 bit FNV-1a hash of the recording file's content
+combined with everything that shapes the spectrum (frame size, sample
+type, Welch segments, fixed point format, DC blocker); renaming or
+copying a recording still hits, editing one byte or changing the DSP
+misses. entries are written to a temporary name and renamed, so
+concurrent tools never see half a file. the directory is $TREMOR_CACHE,
+else $XDG_CACHE_HOME/tremor-spectra, else ~/.cache/tremor-spectra.
+*/
+
+const uint32_t spectrumCacheMagic = 0x43505354;  // "TSPC"
+// bumped whenever the DSP changes what a cached spectrum holds:
+//   2: periodic Hamming window from the generated tables
+//   3: samples saturated to int16 like the device frames
+const uint32_t spectrumCacheVersion = 3;
+
+inline uint64_t fnv1a(const void *data, size_t n, uint64_t hash = 0xCBF29CE484222325ULL) {
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < n; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+// hash of a whole file's content, 0 if it cannot be read
+inline uint64_t fnv1aFile(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    uint64_t hash = 0;
+    if (fstat(fd, &st) == 0) {
+        if (st.st_size == 0) {
+            hash = fnv1a(NULL, 0);
+        } else {
+            void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED) {
+                madvise(map, st.st_size, MADV_SEQUENTIAL);
+                hash = fnv1a(map, st.st_size);
+                munmap(map, st.st_size);
+            }
+        }
+    }
+    close(fd);
+    return hash;
+}
+
+// what the spectra of one recording were computed with; all of it goes into the key
+struct SpectrumConfig {
+    uint16_t frameSize;
+    uint8_t welchSegments;
+    uint8_t sampleFracBits;
+    int32_t dcScale;
+    uint8_t dcBlockerShift;
+    char sampleType[15];  // DspTraits<>::name
+};
+
+// per frame magnitudes of one recording, as TremorDsp::magnitude() reports them
+struct Spectra {
+    uint16_t fftSize = 0;  // points of the transform behind each row (smaller with Welch)
+    uint16_t bins = 0;     // fftSize / 2 + 1
+    std::vector<double> end;       // frame time, seconds since the recording started
+    std::vector<uint8_t> tremor;   // frame label
+    std::vector<double> magnitude; // frames * bins, m/s^2
+
+    size_t frames() const { return end.size(); }
+    const double *row(size_t f) const { return magnitude.data() + f * bins; }
+};
+
+class SpectrumCache {
+public:
+    SpectrumCache() {
+        const char *dir = getenv("TREMOR_CACHE");
+        if (dir && *dir) root = dir;
+        else if ((dir = getenv("XDG_CACHE_HOME")) && *dir) root = std::string(dir) + "/tremor-spectra";
+        else if ((dir = getenv("HOME")) && *dir) root = std::string(dir) + "/.cache/tremor-spectra";
+        else root = ".tremor-spectra";
+    }
+
+    void setDirectory(const std::string &dir) { root = dir; }
+    const std::string &directory() const { return root; }
+
+    static uint64_t key(uint64_t contentHash, const SpectrumConfig &config) {
+        SpectrumConfig c;
+        memset(&c, 0, sizeof(c));  // padding bytes take part in the hash
+        c.frameSize = config.frameSize;
+        c.welchSegments = config.welchSegments;
+        c.sampleFracBits = config.sampleFracBits;
+        c.dcScale = config.dcScale;
+        c.dcBlockerShift = config.dcBlockerShift;
+        memcpy(c.sampleType, config.sampleType, sizeof(c.sampleType));
+        uint64_t h = fnv1a(&spectrumCacheVersion, sizeof(spectrumCacheVersion), contentHash);
+        return fnv1a(&c, sizeof(c), h);
+    }
+
+    bool load(uint64_t key, Spectra &s) const {
+        FILE *f = fopen(path(key).c_str(), "rb");
+        if (!f) return false;
+        Header h;
+        bool ok = fread(&h, sizeof(h), 1, f) == 1 && h.magic == spectrumCacheMagic &&
+                  h.version == spectrumCacheVersion && h.key == key && h.bins == h.fftSize / 2 + 1;
+        if (ok) {
+            s.fftSize = h.fftSize;
+            s.bins = h.bins;
+            s.end.resize(h.frames);
+            s.tremor.resize(h.frames);
+            s.magnitude.resize(h.frames * h.bins);
+            ok = fread(s.end.data(), sizeof(double), h.frames, f) == h.frames &&
+                 fread(s.tremor.data(), 1, h.frames, f) == h.frames &&
+                 fread(s.magnitude.data(), sizeof(double), s.magnitude.size(), f) == s.magnitude.size();
+        }
+        fclose(f);
+        return ok;
+    }
+
+    bool store(uint64_t key, const Spectra &s) const {
+        mkdir(parentOf(root).c_str(), 0755);
+        if (mkdir(root.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        std::string final = path(key);
+        std::string temporary = final + "." + std::to_string(getpid()) + ".tmp";
+        FILE *f = fopen(temporary.c_str(), "wb");
+        if (!f) return false;
+        Header h = {spectrumCacheMagic, spectrumCacheVersion, key, s.frames(), s.fftSize, s.bins, 0};
+        fwrite(&h, sizeof(h), 1, f);
+        fwrite(s.end.data(), sizeof(double), s.frames(), f);
+        fwrite(s.tremor.data(), 1, s.frames(), f);
+        fwrite(s.magnitude.data(), sizeof(double), s.magnitude.size(), f);
+        bool ok = fclose(f) == 0 && rename(temporary.c_str(), final.c_str()) == 0;
+        if (!ok) unlink(temporary.c_str());
+        return ok;
+    }
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint64_t frames;
+        uint16_t fftSize;
+        uint16_t bins;
+        uint32_t reserved;
+    };
+
+    std::string root;
+
+    std::string path(uint64_t key) const {
+        char name[32];
+        snprintf(name, sizeof(name), "/%016llx.spc", (unsigned long long)key);
+        return root + name;
+    }
+
+    static std::string parentOf(const std::string &dir) {
+        size_t slash = dir.find_last_of('/');
+        return slash == std::string::npos || slash == 0 ? "." : dir.substr(0, slash);
+    }
+};
+
+#endif
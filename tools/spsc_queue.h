@@ -0,0 +1,70 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+single producer / single consumer byte ring. one thread writes, one
+thread reads, and neither ever blocks or takes a lock: each side owns
+one index and only reads the other's. Size must be a power of two; the
+indices run free and wrap through the mask.
+*/
+template <size_t Size> class SpscQueue {
+    static_assert(Size && (Size & (Size - 1)) == 0, "Size must be a power of two");
+
+public:
+    // producer side: copies up to n bytes in, returns how many fitted
+    size_t write(const uint8_t *data, size_t n) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        size_t room = Size - (h - t);
+        if (n > room) n = room;
+        copyIn(h, data, n);
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+    // consumer side: copies up to n bytes out, returns how many there were
+    size_t read(uint8_t *data, size_t n) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        if (n > h - t) n = h - t;
+        copyOut(t, data, n);
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    // only exact from the producer side, the consumer may free more at any time
+    size_t space() const {
+        return Size - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_relaxed);
+    }
+
+private:
+    void copyIn(size_t at, const uint8_t *data, size_t n) {
+        size_t offset = at & (Size - 1);
+        size_t first = n < Size - offset ? n : Size - offset;
+        memcpy(buffer + offset, data, first);
+        memcpy(buffer, data + first, n - first);
+    }
+
+    void copyOut(size_t at, uint8_t *data, size_t n) {
+        size_t offset = at & (Size - 1);
+        size_t first = n < Size - offset ? n : Size - offset;
+        memcpy(data, buffer + offset, first);
+        memcpy(data + first, buffer, n - first);
+    }
+
+    // producer and consumer indices on separate cache lines
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) uint8_t buffer[Size];
+};
+
+#endif
@@ -0,0 +1,418 @@
+/*
+sweep - search the detection thresholds over labeled recordings.
+
+    sweep [options] <recording.csv | recording.tses> ...
+
+every recording is run through the same DSP path as the device
+(magnitude, DC blocker, 128-point frame, Hamming window, FFT, band
+peak) once, then the loop() decision logic is replayed for every
+combination of
+
+    --danger LIST         dangerZoneIntensity (10:100:10)
+    --ratio LIST          dangerRatio (0.2:0.8:0.1)
+    --period LIST         evaluationPeriod in seconds (60,120,300,600)
+    --low LIST            lowThreshold (10:50:5)
+    --high LIST           highThreshold (30:90:10)
+
+where LIST is "a,b,c" or "from:to:step". other options:
+
+    --interval S          sampleInterval in seconds (2)
+    --band LO HI          tremor band in Hz (3 6)
+    --welch N             welchSegments (1)
+    --type T              DSP sample type: double, float, int16_t or int32_t
+                          (int16_t, what the circuitplay_classic build runs)
+    --truth F             an evaluation period counts as tremor when at
+                          least this fraction of its frames is labeled (0.5)
+    --threads N           worker threads (all cores)
+    --top N               rows of the alarm table to print (20), 0 for all
+    --cache DIR           spectrum cache directory (see tools/spectrum_cache.h)
+    --no-cache            always recompute the spectra
+
+the recordings need the label column tremor_gen writes (1 while a tremor
+episode is active). alarm configurations are ranked by Youden's J
+(sensitivity + specificity - 1) over evaluation periods, then by mean
+detection latency: the time from an episode's onset to the end of the
+first evaluation period that sounds the alarm while it is going on.
+the per-frame spectra are cached by recording content and DSP setup, so
+a second run over the same recordings (any thresholds, any --band) only
+scans band magnitudes.
+lowThreshold and highThreshold only drive the Neopixels, so they are
+scored per frame in a separate table: how often quiet frames show green
+and how often tremor frames show red (raw thresholds, without the
+display's hysteresis and dwell from include/feedback.h).
+*/
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "dsp.h"
+#include "dcblocker.h"
+#include "session_format.h"
+#include "spectrum_cache.h"
+
+const uint16_t frameSize = 128;
+const double samplingFreq = 50.0;
+const uint8_t sampleFracBits = 15;  // what collectSamples() hands the DSP
+
+struct Options {
+    std::vector<double> danger, ratio, period, low, high;
+    double interval = 2;
+    double bandLow = 3, bandHigh = 6;
+    uint8_t welch = 1;
+    std::string type = "int16_t";  // DSP_SAMPLE_T of the device build being tuned
+    double truth = 0.5;
+    unsigned threads = 0;
+    size_t top = 20;
+    bool cache = true;
+    std::string cacheDir;
+};
+
+struct Samples {
+    std::vector<double> t, x, y, z;  // seconds, m/s^2
+    std::vector<uint8_t> label;
+};
+
+struct Frame {
+    double end;       // seconds since the recording started, when loop() sees the frame
+    double intensity; // analyzeFFT()
+    bool tremor;      // most of the frame's samples are labeled
+};
+
+struct Recording {
+    std::string path;
+    std::vector<Frame> frames;
+};
+
+struct AlarmScore {
+    double danger, ratio, period;
+    unsigned tp = 0, fn = 0, tn = 0, fp = 0;
+    unsigned episodes = 0, detected = 0;
+    double latency = 0;  // summed over detected episodes
+
+    double sensitivity() const { return tp + fn ? (double)tp / (tp + fn) : NAN; }
+    double specificity() const { return tn + fp ? (double)tn / (tn + fp) : NAN; }
+    double youden() const {
+        double j = sensitivity() + specificity() - 1;
+        return isnan(j) ? -2 : j;
+    }
+};
+
+static bool parseList(const char *text, std::vector<double> &out) {
+    out.clear();
+    double from, to, step;
+    if (sscanf(text, "%lf:%lf:%lf", &from, &to, &step) == 3) {
+        if (step <= 0) return false;
+        for (double v = from; v <= to + step * 1e-9; v += step) out.push_back(v);
+        return !out.empty();
+    }
+    for (const char *p = text; *p;) {
+        char *end;
+        out.push_back(strtod(p, &end));
+        if (end == p) return false;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return !out.empty();
+}
+
+static bool loadCsv(const char *path, Samples &s) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '@' || line[0] == '#') continue;
+        double us, x, y, z;
+        int label = 0;
+        if (sscanf(line, "%lf,%lf,%lf,%lf,%d", &us, &x, &y, &z, &label) < 4) continue;
+        s.t.push_back(us * 1e-6);
+        s.x.push_back(x);
+        s.y.push_back(y);
+        s.z.push_back(z);
+        s.label.push_back(label);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool loadSession(const char *path, Samples &s) {
+    SessionReader session;
+    if (!session.open(path)) return false;
+    const char *names[] = {"t_us", "x", "y", "z", "label"};
+    std::vector<double> *targets[] = {&s.t, &s.x, &s.y, &s.z, NULL};
+    for (int i = 0; i < 5; i++) {
+        int c = session.find(names[i]);
+        if (c < 0) return false;
+        std::vector<int64_t> values;
+        if (!session.read(c, values)) return false;
+        double scale = session.column(c).info->scale;
+        if (targets[i]) {
+            targets[i]->resize(values.size());
+            for (size_t r = 0; r < values.size(); r++) (*targets[i])[r] = values[r] * scale;
+        } else {
+            s.label.assign(values.begin(), values.end());
+        }
+    }
+    return true;
+}
+
+// DspTraits<T>::name() of the --type, NULL if it is not one TremorDsp takes
+static const char *sampleTypeName(const std::string &type) {
+    if (type == "double") return DspTraits<double>::name();
+    if (type == "float") return DspTraits<float>::name();
+    if (type == "int16_t") return DspTraits<int16_t>::name();
+    if (type == "int32_t") return DspTraits<int32_t>::name();
+    return NULL;
+}
+
+static SpectrumConfig spectrumConfig(const Options &o) {
+    SpectrumConfig c = {frameSize, o.welch, sampleFracBits, dcScale, dcBlockerShift, {}};
+    strncpy(c.sampleType, sampleTypeName(o.type), sizeof(c.sampleType) - 1);
+    return c;
+}
+
+// frame spectra exactly as performFFT() leaves them with the device running throughout
+template <typename T> static void analyze(const Samples &s, const Options &o, Spectra &out) {
+    TremorDsp<T, frameSize> dsp;
+    DcBlocker dc;
+    uint16_t index = 0, labeled = 0;
+    double start = s.t.empty() ? 0 : s.t[0];
+    for (size_t i = 0; i < s.t.size(); i++) {
+        double x = s.x[i], y = s.y[i], z = s.z[i];
+        int32_t magnitude = sqrt(x * x + y * y + z * z) * dcScale;
+        int32_t sample = dc.step(magnitude);  // saturated to int16 like the acquisition frames
+        dsp.setSample(index, sample > 32767 ? 32767 : (sample < -32768 ? -32768 : sample), sampleFracBits);
+        labeled += s.label[i] != 0;
+        if (++index < frameSize) continue;
+        if (o.welch > 1) dsp.welch(o.welch);
+        else dsp.transform();
+        out.fftSize = dsp.fftSize;
+        out.bins = dsp.fftSize / 2 + 1;
+        out.end.push_back(s.t[i] - start);
+        out.tremor.push_back(labeled * 2 > frameSize);
+        for (uint16_t k = 0; k < out.bins; k++) out.magnitude.push_back(dsp.magnitude(k));
+        index = labeled = 0;
+    }
+}
+
+static void analyze(const Samples &s, const Options &o, Spectra &out) {
+    if (o.type == "double") analyze<double>(s, o, out);
+    else if (o.type == "float") analyze<float>(s, o, out);
+    else if (o.type == "int16_t") analyze<int16_t>(s, o, out);
+    else analyze<int32_t>(s, o, out);
+}
+
+// analyzeFFT() over cached spectra, the same bins TremorDsp::bandPeak() looks at
+static std::vector<Frame> bandPeaks(const Spectra &s, const Options &o) {
+    std::vector<Frame> frames;
+    uint16_t first = s.fftSize, last = 0;
+    for (uint16_t i = 1; i < s.fftSize / 2; i++) {
+        double frequency = i * samplingFreq / s.fftSize;
+        if (frequency >= o.bandLow && frequency <= o.bandHigh) {
+            if (i < first) first = i;
+            last = i;
+        }
+    }
+    for (size_t f = 0; f < s.frames(); f++) {
+        const double *row = s.row(f);
+        double peak = 0;
+        for (uint16_t i = first; i <= last; i++)
+            if (row[i] > peak) peak = row[i];
+        frames.push_back({s.end[f], peak, s.tremor[f] != 0});
+    }
+    return frames;
+}
+
+// the sampleInterval / evaluationPeriod bookkeeping of loop(), scored against the labels
+static void score(const Recording &r, const Options &o, AlarmScore &a) {
+    std::vector<std::pair<double, double>> alarmSpans;  // start and end of every period that sounded the alarm
+    double periodStart = 0;
+    unsigned sampleCount = 0, dangerCount = 0, frames = 0, tremorFrames = 0;
+    for (const Frame &f : r.frames) {
+        frames++;
+        tremorFrames += f.tremor;
+        if (f.end - periodStart < o.interval) continue;
+        dangerCount += f.intensity >= a.danger;
+        sampleCount++;
+        if (f.end - periodStart < a.period) continue;
+        bool alarm = (double)dangerCount / sampleCount >= a.ratio;
+        bool tremor = tremorFrames >= o.truth * frames;
+        if (tremor) alarm ? a.tp++ : a.fn++;
+        else alarm ? a.fp++ : a.tn++;
+        if (alarm) alarmSpans.push_back({periodStart, f.end});
+        periodStart = f.end;
+        sampleCount = dangerCount = frames = tremorFrames = 0;
+    }
+
+    // episodes are runs of tremor frames; detected by the first alarm period overlapping one
+    size_t next = 0;
+    for (size_t i = 0; i < r.frames.size(); i++) {
+        if (!r.frames[i].tremor || (i > 0 && r.frames[i - 1].tremor)) continue;
+        double onset = i > 0 ? r.frames[i - 1].end : 0;
+        size_t j = i;
+        while (j + 1 < r.frames.size() && r.frames[j + 1].tremor) j++;
+        double end = r.frames[j].end;
+        a.episodes++;
+        while (next < alarmSpans.size() && alarmSpans[next].second <= onset) next++;
+        if (next < alarmSpans.size() && alarmSpans[next].first < end) {
+            a.detected++;
+            a.latency += alarmSpans[next].second - onset;
+        }
+    }
+}
+
+// runs job(i) for i in [0, count) on every thread, handing out indices as threads free up
+template <typename Job> static void parallelFor(size_t count, unsigned threads, Job job) {
+    std::atomic<size_t> nextIndex{0};
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++) {
+        pool.emplace_back([&]() {
+            for (size_t i; (i = nextIndex.fetch_add(1)) < count;) job(i);
+        });
+    }
+    for (std::thread &t : pool) t.join();
+}
+
+static int usage(const char *self) {
+    fprintf(stderr, "usage: %s [options] <recording.csv | recording.tses> ... (see tools/sweep.cpp)\n", self);
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    Options o;
+    parseList("10:100:10", o.danger);
+    parseList("0.2:0.8:0.1", o.ratio);
+    parseList("60,120,300,600", o.period);
+    parseList("10:50:5", o.low);
+    parseList("30:90:10", o.high);
+    std::vector<Recording> recordings;
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        bool ok = true;
+        if (a[0] != '-') recordings.push_back({a, {}});
+        else if (strcmp(a, "--no-cache") == 0) o.cache = false;
+        else if (i + 1 >= argc) ok = false;
+        else if (strcmp(a, "--danger") == 0) ok = parseList(argv[++i], o.danger);
+        else if (strcmp(a, "--ratio") == 0) ok = parseList(argv[++i], o.ratio);
+        else if (strcmp(a, "--period") == 0) ok = parseList(argv[++i], o.period);
+        else if (strcmp(a, "--low") == 0) ok = parseList(argv[++i], o.low);
+        else if (strcmp(a, "--high") == 0) ok = parseList(argv[++i], o.high);
+        else if (strcmp(a, "--interval") == 0) o.interval = atof(argv[++i]);
+        else if (strcmp(a, "--welch") == 0) o.welch = atoi(argv[++i]);
+        else if (strcmp(a, "--type") == 0) o.type = argv[++i];
+        else if (strcmp(a, "--truth") == 0) o.truth = atof(argv[++i]);
+        else if (strcmp(a, "--threads") == 0) o.threads = atoi(argv[++i]);
+        else if (strcmp(a, "--top") == 0) o.top = atoi(argv[++i]);
+        else if (strcmp(a, "--cache") == 0) o.cacheDir = argv[++i];
+        else if (strcmp(a, "--band") == 0 && i + 2 < argc) {
+            o.bandLow = atof(argv[++i]);
+            o.bandHigh = atof(argv[++i]);
+        } else ok = false;
+        if (!ok) return usage(argv[0]);
+    }
+    if (recordings.empty()) return usage(argv[0]);
+    if (o.welch != 1 && o.welch != 3 && o.welch != 7 && o.welch != 15) {
+        fprintf(stderr, "--welch must be 1, 3, 7 or 15\n");
+        return 2;
+    }
+    if (!sampleTypeName(o.type)) {
+        fprintf(stderr, "--type must be double, float, int16_t or int32_t\n");
+        return 2;
+    }
+    if (o.threads == 0) o.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // one recording per task: cached spectra if there are any, else load and run the DSP
+    SpectrumCache cache;
+    if (!o.cacheDir.empty()) cache.setDirectory(o.cacheDir);
+    std::vector<uint8_t> loaded(recordings.size());  // not vector<bool>: tasks write neighbouring flags concurrently
+    std::atomic<unsigned> hits{0};
+    parallelFor(recordings.size(), o.threads, [&](size_t i) {
+        const std::string &p = recordings[i].path;
+        Spectra spectra;
+        uint64_t key = o.cache ? SpectrumCache::key(fnv1aFile(p.c_str()), spectrumConfig(o)) : 0;
+        if (o.cache && cache.load(key, spectra)) {
+            hits++;
+            loaded[i] = true;
+        } else {
+            Samples s;
+            bool session = p.size() > 5 && p.compare(p.size() - 5, 5, ".tses") == 0;
+            loaded[i] = session ? loadSession(p.c_str(), s) : loadCsv(p.c_str(), s);
+            if (loaded[i]) analyze(s, o, spectra);
+            if (loaded[i] && o.cache && !cache.store(key, spectra))
+                fprintf(stderr, "%s: cannot write the spectrum cache\n", cache.directory().c_str());
+        }
+        if (loaded[i]) recordings[i].frames = bandPeaks(spectra, o);
+    });
+    size_t frameTotal = 0, tremorTotal = 0;
+    for (size_t i = 0; i < recordings.size(); i++) {
+        if (!loaded[i]) {
+            fprintf(stderr, "%s: cannot read samples and labels\n", recordings[i].path.c_str());
+            return 1;
+        }
+        for (const Frame &f : recordings[i].frames) tremorTotal += f.tremor;
+        frameTotal += recordings[i].frames.size();
+    }
+    printf("%zu recordings (%u spectra cached), %zu frames, %zu labeled tremor\n", recordings.size(), hits.load(),
+           frameTotal, tremorTotal);
+
+    // one alarm configuration per task, each scored over every recording
+    std::vector<AlarmScore> alarms;
+    for (double d : o.danger)
+        for (double r : o.ratio)
+            for (double p : o.period) {
+                AlarmScore a;
+                a.danger = d;
+                a.ratio = r;
+                a.period = p;
+                alarms.push_back(a);
+            }
+    parallelFor(alarms.size(), o.threads, [&](size_t i) {
+        for (const Recording &r : recordings) score(r, o, alarms[i]);
+    });
+    std::stable_sort(alarms.begin(), alarms.end(), [](const AlarmScore &a, const AlarmScore &b) {
+        if (a.youden() != b.youden()) return a.youden() > b.youden();
+        double la = a.detected ? a.latency / a.detected : INFINITY;
+        double lb = b.detected ? b.latency / b.detected : INFINITY;
+        return la < lb;
+    });
+
+    printf("\n%7s %6s %7s %7s %7s %7s %9s %10s\n", "danger", "ratio", "period", "sens", "spec", "J", "episodes", "latency_s");
+    size_t rows = o.top && o.top < alarms.size() ? o.top : alarms.size();
+    for (size_t i = 0; i < rows; i++) {
+        const AlarmScore &a = alarms[i];
+        char episodes[24];
+        snprintf(episodes, sizeof(episodes), "%u/%u", a.detected, a.episodes);
+        printf("%7.1f %6.2f %7.0f %7.3f %7.3f %7.3f %9s %10.1f\n", a.danger, a.ratio, a.period, a.sensitivity(),
+               a.specificity(), a.youden() < -1 ? NAN : a.youden(), episodes,
+               a.detected ? a.latency / a.detected : NAN);
+    }
+
+    // Neopixel thresholds, per frame
+    printf("\n%7s %12s    %7s %12s\n", "low", "green_quiet", "high", "red_tremor");
+    size_t displayRows = std::max(o.low.size(), o.high.size());
+    for (size_t i = 0; i < displayRows; i++) {
+        if (i < o.low.size()) {
+            size_t quiet = 0, green = 0;
+            for (const Recording &r : recordings)
+                for (const Frame &f : r.frames)
+                    if (!f.tremor) {
+                        quiet++;
+                        green += f.intensity < o.low[i];
+                    }
+            printf("%7.1f %12.3f    ", o.low[i], quiet ? (double)green / quiet : NAN);
+        } else {
+            printf("%7s %12s    ", "", "");
+        }
+        if (i < o.high.size()) {
+            size_t red = 0;
+            for (const Recording &r : recordings)
+                for (const Frame &f : r.frames) red += f.tremor && f.intensity >= o.high[i];
+            printf("%7.1f %12.3f", o.high[i], tremorTotal ? (double)red / tremorTotal : NAN);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,217 @@
+/*
+tremor_gen - synthetic accelerometer workloads with ground truth.
+
+    tremor_gen [options] > trace.csv
+
+writes a replay trace for the simulator (pio run -e native, see
+lib/ArduinoSim/sim.cpp): "t_us,x,y,z,label" lines in m/s^2, where label
+is 1 while a tremor episode is active and 0 otherwise. the same options
+and seed always produce the same bytes.
+
+    --duration S          length of the trace in seconds (600)
+    --rate HZ             output sample rate (50)
+    --seed N              random seed (1)
+    --tremor-hz F         tremor frequency, 3-12 Hz (4.5)
+    --tremor-jitter F     per-episode frequency spread in Hz (0.3)
+    --tremor-amp A        peak tremor acceleration in m/s^2 (1.5)
+    --am-depth D          amplitude modulation depth 0-1 (0.3)
+    --am-hz F             amplitude modulation rate (0.2)
+    --episodes N          tremor episodes per hour (6); 0 with --continuous
+    --episode-len S       mean episode length in seconds (120)
+    --continuous          tremor for the whole trace
+    --orient-every S      mean seconds between wrist re-orientations (45)
+    --voluntary N         voluntary movements per hour (20)
+    --voluntary-amp A     peak voluntary acceleration in m/s^2 (3)
+    --noise SIGMA         white sensor noise per axis in m/s^2 (0.05)
+*/
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+const double gravity = 9.81;
+
+// xorshift64*, so traces are identical across compilers and standard libraries
+class Random {
+public:
+    explicit Random(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+    double uniform(double lo, double hi) { return lo + (hi - lo) * uniform(); }
+    double exponential(double mean) { return -mean * log(1 - uniform()); }
+    double normal() {
+        double u = uniform(), v = uniform();
+        return sqrt(-2 * log(u > 0 ? u : 1e-300)) * cos(2 * M_PI * v);
+    }
+
+private:
+    uint64_t state;
+};
+
+struct Vec3 {
+    double x, y, z;
+};
+
+static Vec3 randomUnit(Random &rng) {
+    double z = rng.uniform(-1, 1), a = rng.uniform(0, 2 * M_PI), r = sqrt(1 - z * z);
+    return Vec3{r * cos(a), r * sin(a), z};
+}
+
+static Vec3 lerpUnit(const Vec3 &a, const Vec3 &b, double t) {
+    Vec3 v{a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t};
+    double n = sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+    if (n < 1e-9) return b;
+    return Vec3{v.x / n, v.y / n, v.z / n};
+}
+
+// a stretch of time with a shape; episodes are tremor, movements are voluntary
+struct Interval {
+    double start, end;
+    double hz;
+    Vec3 axis;
+    double phase;
+};
+
+struct Config {
+    double duration = 600, rate = 50;
+    uint64_t seed = 1;
+    double tremorHz = 4.5, tremorJitter = 0.3, tremorAmp = 1.5;
+    double amDepth = 0.3, amHz = 0.2;
+    double episodesPerHour = 6, episodeLen = 120;
+    bool continuous = false;
+    double orientEvery = 45;
+    double voluntaryPerHour = 20, voluntaryAmp = 3;
+    double noise = 0.05;
+};
+
+static bool parse(int argc, char **argv, Config &c) {
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        bool hasValue = i + 1 < argc;
+        double v = hasValue ? atof(argv[i + 1]) : 0;
+        if (strcmp(a, "--continuous") == 0) { c.continuous = true; continue; }
+        if (!hasValue) return false;
+        if (strcmp(a, "--duration") == 0) c.duration = v;
+        else if (strcmp(a, "--rate") == 0) c.rate = v;
+        else if (strcmp(a, "--seed") == 0) c.seed = strtoull(argv[i + 1], NULL, 10);
+        else if (strcmp(a, "--tremor-hz") == 0) c.tremorHz = v;
+        else if (strcmp(a, "--tremor-jitter") == 0) c.tremorJitter = v;
+        else if (strcmp(a, "--tremor-amp") == 0) c.tremorAmp = v;
+        else if (strcmp(a, "--am-depth") == 0) c.amDepth = v;
+        else if (strcmp(a, "--am-hz") == 0) c.amHz = v;
+        else if (strcmp(a, "--episodes") == 0) c.episodesPerHour = v;
+        else if (strcmp(a, "--episode-len") == 0) c.episodeLen = v;
+        else if (strcmp(a, "--orient-every") == 0) c.orientEvery = v;
+        else if (strcmp(a, "--voluntary") == 0) c.voluntaryPerHour = v;
+        else if (strcmp(a, "--voluntary-amp") == 0) c.voluntaryAmp = v;
+        else if (strcmp(a, "--noise") == 0) c.noise = v;
+        else return false;
+        i++;
+    }
+    return c.duration > 0 && c.rate > 0 && c.tremorHz >= 3 && c.tremorHz <= 12 &&
+           c.amDepth >= 0 && c.amDepth <= 1;
+}
+
+// Poisson arrivals of intervals with exponentially distributed lengths
+static std::vector<Interval> schedule(Random &rng, const Config &c, double perHour, double meanLen,
+                                      double hz, double hzSpread) {
+    std::vector<Interval> out;
+    if (perHour <= 0) return out;
+    double t = rng.exponential(3600 / perHour);
+    while (t < c.duration) {
+        double len = rng.exponential(meanLen) + 1;
+        out.push_back(Interval{t, std::min(t + len, c.duration), hz + rng.uniform(-hzSpread, hzSpread),
+                               randomUnit(rng), rng.uniform(0, 2 * M_PI)});
+        t += len + rng.exponential(3600 / perHour);
+    }
+    return out;
+}
+
+static const Interval *active(const std::vector<Interval> &list, size_t &cursor, double t) {
+    while (cursor < list.size() && list[cursor].end <= t) cursor++;
+    if (cursor < list.size() && list[cursor].start <= t) return &list[cursor];
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    Config c;
+    if (!parse(argc, argv, c)) {
+        fprintf(stderr, "usage: %s [options] > trace.csv (see tools/tremor_gen.cpp)\n", argv[0]);
+        return 2;
+    }
+    Random rng(c.seed);
+
+    std::vector<Interval> episodes;
+    if (c.continuous) {
+        episodes.push_back(Interval{0, c.duration, c.tremorHz, randomUnit(rng), 0});
+    } else {
+        episodes = schedule(rng, c, c.episodesPerHour, c.episodeLen, c.tremorHz, c.tremorJitter);
+    }
+    // voluntary movements: slow (0.3-2 Hz), short, large
+    std::vector<Interval> movements = schedule(rng, c, c.voluntaryPerHour, 4, 1.15, 0.85);
+
+    printf("# tremor_gen seed=%llu duration=%g rate=%g tremor=%gHz amp=%g am=%g@%gHz "
+           "episodes/h=%g len=%g voluntary/h=%g noise=%g\n",
+           (unsigned long long)c.seed, c.duration, c.rate, c.tremorHz, c.tremorAmp, c.amDepth,
+           c.amHz, c.continuous ? 0 : c.episodesPerHour, c.episodeLen, c.voluntaryPerHour, c.noise);
+    double tremorSeconds = 0;
+    for (const Interval &e : episodes) {
+        printf("# episode %.3f-%.3f s at %.2f Hz\n", e.start, e.end, e.hz);
+        tremorSeconds += e.end - e.start;
+    }
+
+    // gravity direction in the device frame drifts to a new orientation now and then
+    Vec3 down{0, 0, 1}, from = down, to = down;
+    double turnStart = 0, turnEnd = 0, nextTurn = rng.exponential(c.orientEvery);
+    size_t episodeCursor = 0, movementCursor = 0;
+    uint64_t count = (uint64_t)(c.duration * c.rate);
+
+    for (uint64_t i = 0; i < count; i++) {
+        double t = i / c.rate;
+        if (c.orientEvery > 0 && t >= nextTurn) {
+            from = down;
+            to = lerpUnit(down, randomUnit(rng), 0.6);
+            turnStart = t;
+            turnEnd = t + rng.uniform(0.5, 2);
+            nextTurn = turnEnd + rng.exponential(c.orientEvery);
+        }
+        if (t < turnEnd) down = lerpUnit(from, to, (t - turnStart) / (turnEnd - turnStart));
+        else down = to;
+
+        Vec3 a{down.x * gravity, down.y * gravity, down.z * gravity};
+        const Interval *e = active(episodes, episodeCursor, t);
+        if (e) {
+            double envelope = 1 - c.amDepth * (0.5 + 0.5 * sin(2 * M_PI * c.amHz * t));
+            // 1 s fade in and out so onsets are not step functions
+            double edge = std::min(1.0, std::min(t - e->start, e->end - t));
+            double s = c.tremorAmp * envelope * edge * sin(2 * M_PI * e->hz * (t - e->start) + e->phase);
+            a.x += e->axis.x * s;
+            a.y += e->axis.y * s;
+            a.z += e->axis.z * s;
+        }
+        const Interval *m = active(movements, movementCursor, t);
+        if (m) {
+            double span = m->end - m->start;
+            double s = c.voluntaryAmp * sin(M_PI * (t - m->start) / span) * sin(2 * M_PI * m->hz * (t - m->start));
+            a.x += m->axis.x * s;
+            a.y += m->axis.y * s;
+            a.z += m->axis.z * s;
+        }
+        a.x += c.noise * rng.normal();
+        a.y += c.noise * rng.normal();
+        a.z += c.noise * rng.normal();
+
+        printf("%llu,%.4f,%.4f,%.4f,%d\n", (unsigned long long)(t * 1e6 + 0.5), a.x, a.y, a.z, e ? 1 : 0);
+    }
+    fprintf(stderr, "%llu samples, %.1f s of tremor in %zu episodes, %zu voluntary movements\n",
+            (unsigned long long)count, tremorSeconds, episodes.size(), movements.size());
+    return 0;
+}